@@ -19,15 +19,31 @@ from .I2CMaster import *
 from .SPI import *
 from .SPIMaster import *
 from .SPISlave import *
+from .hotplug import DeviceWatcher
+from .group import DeviceGroup
 
 __all__ = [
     'FT2XXDeviceError',
     'FT4222DeviceError',
     'SysClock',
+    'Event',
+    'Purge',
+    'TUNING_PROFILES',
     'createDeviceInfoList',
     'getDeviceInfoDetail',
+    'listDevices',
+    'DeviceWatcher',
+    'DeviceGroup',
     'openBySerial',
     'openByDescription',
     'openByLocation',
+    'openMany',
     'FT4222',
+    'SPIBatch',
+    'I2CSlaveStream',
+    'SPISlaveStream',
+    'GpioCapture',
+    'RegisterMap',
+    'CommandQueue',
+    'CommandFuture',
 ]
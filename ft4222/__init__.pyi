@@ -4,3 +4,5 @@ from .I2CMaster import *
 from .SPI import *
 from .SPIMaster import *
 from .SPISlave import *
+from .hotplug import DeviceWatcher as DeviceWatcher
+from .group import DeviceGroup as DeviceGroup
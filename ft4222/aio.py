@@ -0,0 +1,161 @@
+#  _____ _____ _____
+# |_    |   __| __  |
+# |_| | |__   |    -|
+# |_|_|_|_____|__|__|
+# MSR Electronics GmbH
+# SPDX-License-Identifier: MIT
+#
+
+"""Asyncio
+
+Use FT4222 devices from asyncio.
+
+Every :class:`AsyncFT4222` runs its device in queued mode (:class:`ft4222.CommandQueue`),
+whose worker thread executes the calls in order without the GIL. Completions are
+signalled through one file descriptor per device (an eventfd on Linux, a pipe elsewhere)
+watched by the event loop, so many requests in flight don't need a thread or an executor
+job each::
+
+    async with AsyncFT4222(ft4222.openByDescription('FT4222 A')) as dev:
+        await dev.i2cMaster_Init(400)
+        data = await dev.i2cMaster_Read(0x50, 16)
+"""
+
+import asyncio
+import collections
+import os
+
+from . import ft4222 as _ft4222
+
+__all__ = ['AsyncFT4222']
+
+
+class AsyncFT4222:
+    """Asyncio interface of a :class:`ft4222.FT4222`.
+
+    All methods of :class:`ft4222.FT4222` are available with the same arguments. They
+    queue the call right away and return an :obj:`asyncio.Future` to await the result.
+    The calls are executed in the order they are made, so several requests can be issued
+    before awaiting the first one. Buffers passed to ``*_into`` methods and write data
+    must not be touched until the call has completed.
+
+    The device is put into queued mode (:meth:`ft4222.FT4222.queue`), the transfers run
+    in its worker thread without the GIL and are pipelined with the submission.
+
+    Args:
+        dev (:obj:`ft4222.FT4222`): Opened device, owned by this object from now on
+        loop (:obj:`asyncio.AbstractEventLoop`): Event loop, the running loop if None
+
+    """
+
+    def __init__(self, dev, loop=None):
+        self.dev = dev
+        self._loop = loop or asyncio.get_running_loop()
+        self._pending = collections.deque()
+        self._rfd = self._wfd = None
+        try:
+            if hasattr(os, 'eventfd'):
+                self._rfd = self._wfd = os.eventfd(0, os.EFD_NONBLOCK | os.EFD_CLOEXEC)
+            else:
+                self._rfd, self._wfd = os.pipe()
+                os.set_blocking(self._rfd, False)
+            self._loop.add_reader(self._rfd, self._drain)
+        except (NotImplementedError, OSError, AttributeError):
+            # e.g. the proactor event loop on Windows can't watch file descriptors
+            self._closeFds()
+        if self._wfd is None:
+            self._queue = dev.queue(callback=self._wakeup)
+        else:
+            self._queue = dev.queue(notifyFd=self._wfd)
+
+    def _closeFds(self):
+        for fd in {self._rfd, self._wfd} - {None}:
+            os.close(fd)
+        self._rfd = self._wfd = None
+
+    def _wakeup(self):
+        """Called from the worker thread if there is no file descriptor to signal"""
+        self._loop.call_soon_threadsafe(self._drain)
+
+    def _drain(self):
+        if self._rfd is not None:
+            try:
+                while len(os.read(self._rfd, 4096)) == 4096:
+                    pass
+            except BlockingIOError:
+                pass
+        # commands complete in order
+        while self._pending and self._pending[0][0].done():
+            command, future = self._pending.popleft()
+            if future.cancelled():
+                continue
+            try:
+                future.set_result(command.result())
+            except BaseException as e:
+                future.set_exception(e)
+
+    def _track(self, command):
+        future = self._loop.create_future()
+        self._pending.append((command, future))
+        return future
+
+    def submit(self, fn, *args, **kwargs):
+        """Execute fn(*args, **kwargs) in the worker thread of the device.
+
+        Returns:
+            :obj:`asyncio.Future`: Result of the call
+
+        """
+        if self._queue is None:
+            raise RuntimeError("device is closed")
+        return self._track(self._queue.call(fn, *args, **kwargs))
+
+    async def close(self):
+        """Wait for the pending calls and close the device."""
+        if self._queue is None:
+            return
+        try:
+            # calls complete in order, the pending ones are done with this one
+            await self.submit(_noop)
+        finally:
+            self._queue.close()
+            self._queue = None
+            if self._rfd is not None:
+                self._loop.remove_reader(self._rfd)
+                self._closeFds()
+            self._drain()
+        # the device can only be closed once it has left queued mode
+        self.dev.close()
+
+    async def __aenter__(self):
+        return self
+
+    async def __aexit__(self, *exc):
+        await self.close()
+
+
+def _noop():
+    pass
+
+
+def _method(name):
+    method = getattr(_ft4222.FT4222, name)
+
+    if hasattr(_ft4222.CommandQueue, name):
+        # executed natively by the command queue
+        def call(self, *args, **kwargs):
+            if self._queue is None:
+                raise RuntimeError("device is closed")
+            return self._track(getattr(self._queue, name)(*args, **kwargs))
+    else:
+        def call(self, *args, **kwargs):
+            return self.submit(method, self.dev, *args, **kwargs)
+    call.__name__ = call.__qualname__ = name
+    call.__doc__ = method.__doc__
+    return call
+
+
+for _name in dir(_ft4222.FT4222):
+    if not _name.startswith('_') and not hasattr(AsyncFT4222, _name) and callable(getattr(_ft4222.FT4222, _name)):
+        setattr(AsyncFT4222, _name, _method(_name))
+del _name
@@ -0,0 +1,230 @@
+#  _____ _____ _____
+# |_    |   __| __  |
+# |_| | |__   |    -|
+# |_|_|_|_____|__|__|
+# MSR Electronics GmbH
+# SPDX-License-Identifier: MIT
+#
+
+"""Benchmark
+
+Microbenchmarks for the transfer primitives of :class:`ft4222.FT4222`.
+
+Every primitive is run for a range of transfer sizes (and SPI clock dividers), the
+result is reported as JSON with ops/s, MB/s and the p50/p99 latency of a single call::
+
+    python -m ft4222.bench --description 'FT4222 A' --sizes 1 64 4096
+    python -m ft4222.bench --sim --output bench.json
+
+With ``--sim`` the benchmarks run against the simulated backend, which needs the module
+to be built with ``FT4222_SIM=1`` (see ``sim/ft4222sim.c``). The whole wrapper is
+measured then, only the library calls are replaced by the model with the USB latency
+given by ``--sim-latency``.
+"""
+
+import argparse
+import json
+import os
+import platform
+import sys
+import time
+
+from . import FT2XXDeviceError, openByDescription, openByLocation, openBySerial
+from .GPIO import Dir, Port
+from .SPI import Cpha, Cpol
+from .SPIMaster import Clock, Mode, SlaveSelect
+
+__all__ = ['BENCHMARKS', 'run']
+
+
+def _measure(fn, size, duration, minIterations):
+    """Call fn repeatedly and return the statistics of the call latencies."""
+    for _ in range(min(minIterations, 3)):
+        fn()
+    lat = []
+    clock = time.perf_counter_ns
+    start = clock()
+    end = start + int(duration * 1e9)
+    t = start
+    while t < end or len(lat) < minIterations:
+        fn()
+        t1 = clock()
+        lat.append(t1 - t)
+        t = t1
+    total = (t - start) / 1e9
+    lat.sort()
+    n = len(lat)
+    return {
+        'iterations': n,
+        'ops_per_s': n / total,
+        'mb_per_s': n * size / total / 1e6,
+        'p50_us': lat[n // 2] / 1e3,
+        'p99_us': lat[min(n - 1, (n * 99) // 100)] / 1e3,
+    }
+
+
+def _spi(op):
+    def bench(dev, args, emit):
+        for clock in args.clocks:
+            mode = Mode.QUAD if op == 'MultiReadWrite' else Mode.SINGLE
+            dev.spiMaster_Init(mode, clock, Cpol.IDLE_LOW, Cpha.CLK_LEADING, SlaveSelect.SS0)
+            for size in args.sizes:
+                data = bytes(size)
+                if op == 'SingleRead':
+                    fn = lambda: dev.spiMaster_SingleRead(size, True)
+                elif op == 'SingleWrite':
+                    fn = lambda: dev.spiMaster_SingleWrite(data, True)
+                elif op == 'SingleReadWrite':
+                    fn = lambda: dev.spiMaster_SingleReadWrite(data, True)
+                else:
+                    if size > 0xFFFF:
+                        continue
+                    fn = lambda: dev.spiMaster_MultiReadWrite(b'\x6b', b'\x00\x00\x00\x00', size)
+                emit('spiMaster_' + op, size, fn, clock=clock.name)
+    return bench
+
+
+def _i2c(op):
+    def bench(dev, args, emit):
+        dev.i2cMaster_Init(args.i2c_kbps)
+        for size in args.sizes:
+            if size > 0xFFFF:
+                continue
+            data = bytes(size)
+            if op == 'Read':
+                fn = lambda: dev.i2cMaster_Read(args.i2c_addr, size)
+            else:
+                fn = lambda: dev.i2cMaster_Write(args.i2c_addr, data)
+            emit('i2cMaster_' + op, size, fn, kbps=args.i2c_kbps)
+    return bench
+
+
+def _gpio(dev, args, emit):
+    dev.setSuspendOut(False)
+    dev.gpio_Init(gpio2=Dir.OUTPUT)
+    state = [False]
+
+    def toggle():
+        state[0] = not state[0]
+        dev.gpio_Write(Port.P2, state[0])
+    emit('gpio_Write', 0, toggle)
+
+
+BENCHMARKS = {
+    'spi_read': _spi('SingleRead'),
+    'spi_write': _spi('SingleWrite'),
+    'spi_readwrite': _spi('SingleReadWrite'),
+    'spi_multi': _spi('MultiReadWrite'),
+    'i2c_read': _i2c('Read'),
+    'i2c_write': _i2c('Write'),
+    'gpio_toggle': _gpio,
+}
+
+
+def run(openDevice, benchmarks=None, sizes=(1, 16, 256, 4096), clocks=(Clock.DIV_4, Clock.DIV_16),
+        duration=0.5, minIterations=10, i2c_addr=0x50, i2c_kbps=400, progress=None):
+    """Run benchmarks and return the results.
+
+    Each benchmark opens its own device, so the interfaces don't interfere.
+
+    Args:
+        openDevice (callable): Returns a new :class:`ft4222.FT4222`
+        benchmarks (list): Names out of :data:`BENCHMARKS`, None for all
+        sizes (list): Transfer sizes in bytes
+        clocks (list): SPI clock dividers (:obj:`ft4222.SPIMaster.Clock`)
+        duration (float): Measuring time per data point in seconds
+        minIterations (int): Minimal number of calls per data point
+        i2c_addr (int): Address of the I2C slave used for the I2C benchmarks
+        i2c_kbps (int): I2C bus speed in kbit/s
+        progress (callable): Called with each result as it is measured
+
+    Returns:
+        list: One dict per data point
+
+    """
+    args = argparse.Namespace(sizes=list(sizes), clocks=[Clock(c) for c in clocks],
+                              i2c_addr=i2c_addr, i2c_kbps=i2c_kbps)
+    results = []
+
+    for name in benchmarks or BENCHMARKS:
+        def emit(op, size, fn, **params):
+            result = {'benchmark': name, 'op': op, 'size': size}
+            result.update(params)
+            result.update(_measure(fn, size, duration, minIterations))
+            results.append(result)
+            if progress is not None:
+                progress(result)
+
+        dev = openDevice()
+        try:
+            BENCHMARKS[name](dev, args, emit)
+        finally:
+            dev.close()
+    return results
+
+
+def main(argv=None):
+    parser = argparse.ArgumentParser(prog='python -m ft4222.bench', description=__doc__.split('\n\n')[1])
+    target = parser.add_mutually_exclusive_group()
+    target.add_argument('--description', default='FT4222 A', help="open device by description (default: '%(default)s')")
+    target.add_argument('--serial', help='open device by serial number')
+    target.add_argument('--location', type=lambda x: int(x, 0), help='open device by location')
+    target.add_argument('--sim', action='store_true', help='use the simulated backend (module built with FT4222_SIM=1)')
+    parser.add_argument('--sim-latency', type=float, default=125e-6, help='USB round trip of the simulated device in seconds')
+    parser.add_argument('--benchmarks', nargs='+', choices=list(BENCHMARKS), help='benchmarks to run (default: all)')
+    parser.add_argument('--sizes', nargs='+', type=int, default=[1, 16, 256, 4096],
+                        help='transfer sizes in bytes (a 65535 byte I2C transfer takes 1.5 s at 400 kbit/s)')
+    parser.add_argument('--clocks', nargs='+', choices=[c.name for c in Clock if c != Clock.NONE], default=['DIV_4', 'DIV_16'],
+                        help='SPI clock dividers')
+    parser.add_argument('--duration', type=float, default=0.5, help='measuring time per data point in seconds')
+    parser.add_argument('--min-iterations', type=int, default=10, help='minimal number of calls per data point')
+    parser.add_argument('--i2c-addr', type=lambda x: int(x, 0), default=0x50, help='I2C slave address')
+    parser.add_argument('--i2c-kbps', type=int, default=400, help='I2C bus speed in kbit/s')
+    parser.add_argument('--output', '-o', help='write the JSON report to this file instead of stdout')
+    parser.add_argument('--quiet', '-q', action='store_true', help='no progress output on stderr')
+    args = parser.parse_args(argv)
+
+    if args.sim:
+        # read by the simulated backend on its first call
+        os.environ['FT4222SIM_LATENCY_US'] = str(round(args.sim_latency * 1e6))
+        try:
+            openBySerial(b'SIM0000A').close()
+        except FT2XXDeviceError:
+            parser.error('--sim needs the module built against the simulated backend (FT4222_SIM=1)')
+        openDevice = lambda: openBySerial(b'SIM0000A')
+        target = {'sim': True, 'latency': args.sim_latency}
+    elif args.serial is not None:
+        openDevice = lambda: openBySerial(args.serial.encode())
+        target = {'serial': args.serial}
+    elif args.location is not None:
+        openDevice = lambda: openByLocation(args.location)
+        target = {'location': args.location}
+    else:
+        openDevice = lambda: openByDescription(args.description)
+        target = {'description': args.description}
+
+    def progress(r):
+        print('{benchmark:14} {:8} {size:>6} B {ops_per_s:>10.1f} ops/s {mb_per_s:>8.3f} MB/s'
+              ' p50 {p50_us:>9.1f} us p99 {p99_us:>9.1f} us'.format(r.get('clock', ''), **r), file=sys.stderr)
+
+    results = run(openDevice, args.benchmarks, args.sizes, [Clock[c] for c in args.clocks],
+                  args.duration, args.min_iterations, args.i2c_addr, args.i2c_kbps,
+                  None if args.quiet else progress)
+
+    report = {
+        'target': target,
+        'python': platform.python_version(),
+        'platform': platform.platform(),
+        'time': time.strftime('%Y-%m-%dT%H:%M:%S%z'),
+        'results': results,
+    }
+    if args.output:
+        with open(args.output, 'w') as f:
+            json.dump(report, f, indent=2)
+    else:
+        json.dump(report, sys.stdout, indent=2)
+        print()
+
+
+if __name__ == '__main__':
+    main()
@@ -7,7 +7,7 @@
 #
 #cython: language_level=3
 
-cdef extern from "ftd2xx.h":
+cdef extern from "ftd2xx.h" nogil:
     ctypedef unsigned int DWORD
     ctypedef unsigned int ULONG
     ctypedef unsigned short USHORT
@@ -70,8 +70,27 @@ cdef extern from "ftd2xx.h":
     ctypedef PVOID FT_HANDLE
     ctypedef ULONG FT_STATUS
 
+    cdef enum:
+        FT_PURGE_RX = 1
+        FT_PURGE_TX = 2
+
+    cdef enum:
+        FT_FLAGS_OPENED = 1
+        FT_FLAGS_HISPEED = 2
+
+    ctypedef struct FT_DEVICE_LIST_INFO_NODE:
+        ULONG Flags
+        ULONG Type
+        ULONG ID
+        DWORD LocId
+        char SerialNumber[16]
+        char Description[64]
+        FT_HANDLE ftHandle
+
     FT_STATUS FT_CreateDeviceInfoList(LPDWORD lpdwNumDevs)
 
+    FT_STATUS FT_GetDeviceInfoList(FT_DEVICE_LIST_INFO_NODE *pDest, LPDWORD lpdwNumDevs)
+
     FT_STATUS FT_GetDeviceInfoDetail(DWORD dwIndex, LPDWORD lpdwFlags,
         LPDWORD lpdwType, LPDWORD lpdwID, LPDWORD lpdwLocId, LPVOID lpSerialNumber,
         LPVOID lpDescription, FT_HANDLE *pftHandle)
@@ -84,3 +103,7 @@ cdef extern from "ftd2xx.h":
     FT_STATUS FT_VendorCmdSet(FT_HANDLE ftHandle, UCHAR Request, UCHAR *Buf, USHORT Len);
 
     FT_STATUS FT_SetTimeouts(FT_HANDLE ftHandle, ULONG ReadTimeout, ULONG WriteTimeout);
+    FT_STATUS FT_SetLatencyTimer(FT_HANDLE ftHandle, UCHAR ucLatency);
+    FT_STATUS FT_GetLatencyTimer(FT_HANDLE ftHandle, PUCHAR pucLatency);
+    FT_STATUS FT_SetUSBParameters(FT_HANDLE ftHandle, ULONG ulInTransferSize, ULONG ulOutTransferSize);
+    FT_STATUS FT_Purge(FT_HANDLE ftHandle, ULONG Mask);
@@ -12,7 +12,7 @@ from libc.stdint cimport *
 from .cftd2xx cimport *
 
 
-cdef extern from "libft4222.h":
+cdef extern from "libft4222.h" nogil:
     ctypedef uint8_t  uint8
     ctypedef uint16_t uint16
     ctypedef uint32_t uint32
@@ -68,6 +68,8 @@ cdef extern from "libft4222.h":
         FT4222_EVENT_NOT_SUPPORTED = 1021
         FT4222_FUN_NOT_SUPPORT = 1022
 
+    enum: FT4222_EVENT_RXCHAR
+
     ctypedef enum FT4222_ClockRate:
         SYS_CLK_60 = 0
         SYS_CLK_24 = 1
@@ -167,6 +169,7 @@ cdef extern from "libft4222.h":
     FT4222_STATUS FT4222_GPIO_SetInputTrigger(FT_HANDLE ftHandle, GPIO_Port portNum, GPIO_Trigger trigger)
     FT4222_STATUS FT4222_GPIO_GetTriggerStatus(FT_HANDLE ftHandle, GPIO_Port portNum, uint16* queueSize)
     FT4222_STATUS FT4222_GPIO_ReadTriggerQueue(FT_HANDLE ftHandle, GPIO_Port portNum, GPIO_Trigger* events, uint16 readSize, uint16* sizeofRead)
+    FT4222_STATUS FT4222_GPIO_SetWaveFormMode(FT_HANDLE ftHandle, BOOL enable)
     # FT4222 SPI Functions
     FT4222_STATUS FT4222_SPI_Reset(FT_HANDLE ftHandle);
     FT4222_STATUS FT4222_SPI_ResetTransaction(FT_HANDLE ftHandle, uint8 spiIdx);
@@ -185,3 +188,13 @@ cdef extern from "libft4222.h":
     FT4222_STATUS FT4222_SPISlave_Read(FT_HANDLE ftHandle, uint8* buffer, uint16 bufferSize, uint16* sizeOfRead);
     FT4222_STATUS FT4222_SPISlave_Write(FT_HANDLE ftHandle, uint8* buffer, uint16 bufferSize, uint16* sizeTransferred);
     FT4222_STATUS FT4222_SPISlave_RxQuickResponse(FT_HANDLE ftHandle, BOOL enable);
+    # FT4222 I2C Slave
+    FT4222_STATUS FT4222_I2CSlave_Init(FT_HANDLE ftHandle)
+    FT4222_STATUS FT4222_I2CSlave_Reset(FT_HANDLE ftHandle)
+    FT4222_STATUS FT4222_I2CSlave_GetAddress(FT_HANDLE ftHandle, uint8* addr)
+    FT4222_STATUS FT4222_I2CSlave_SetAddress(FT_HANDLE ftHandle, uint8 addr)
+    FT4222_STATUS FT4222_I2CSlave_GetRxStatus(FT_HANDLE ftHandle, uint16* pRxSize)
+    FT4222_STATUS FT4222_I2CSlave_Read(FT_HANDLE ftHandle, uint8* buffer, uint16 bufferSize, uint16* sizeTransferred)
+    FT4222_STATUS FT4222_I2CSlave_Write(FT_HANDLE ftHandle, uint8* buffer, uint16 bufferSize, uint16* sizeTransferred)
+    FT4222_STATUS FT4222_I2CSlave_SetClockStretch(FT_HANDLE ftHandle, BOOL enable)
+    FT4222_STATUS FT4222_I2CSlave_SetRespWord(FT_HANDLE ftHandle, uint8 responseWord)
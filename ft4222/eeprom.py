@@ -0,0 +1,157 @@
+#  _____ _____ _____
+# |_    |   __| __  |
+# |_| | |__   |    -|
+# |_|_|_|_____|__|__|
+# MSR Electronics GmbH
+# SPDX-License-Identifier: MIT
+#
+
+"""EEPROM
+
+Program and verify 24Cxx-style I2C EEPROMs connected to the I2C master interface.
+
+Writes are split at the page boundaries and the end of every write cycle is detected by
+acknowledge polling with :meth:`ft4222.FT4222.i2cMaster_GetStatus`. Whole images are
+written, polled and verified in the extension without the GIL::
+
+    dev.i2cMaster_Init(400)
+    eeprom = I2CEEPROM.part(dev, '24C256')
+    eeprom.write(0, image)
+"""
+
+from .ft4222 import _I2CEEPROM
+
+__all__ = ['PARTS', 'I2CEEPROM']
+
+#: Size and page size in bytes of common parts
+PARTS = {
+    '24C01': (128, 8),
+    '24C02': (256, 8),
+    '24C04': (512, 16),
+    '24C08': (1024, 16),
+    '24C16': (2048, 16),
+    '24C32': (4096, 32),
+    '24C64': (8192, 32),
+    '24C128': (16384, 64),
+    '24C256': (32768, 64),
+    '24C512': (65536, 128),
+}
+
+
+class I2CEEPROM(_I2CEEPROM):
+    """I2C EEPROM.
+
+    The device must be initialized as I2C master. Parts up to 2048 bytes are addressed
+    with one byte, the address bits above go into the slave address (24C04 to 24C16).
+    Larger parts are addressed with two bytes.
+
+    Args:
+        dev (:obj:`ft4222.FT4222`): Device initialized as I2C master
+        size (int): Size in bytes
+        pageSize (int): Page size in bytes
+        addr (int): Slave address
+        addrBytes (int): Address bytes, None to derive it from size
+        pollInterval (int): Microseconds to sleep between two acknowledge polls
+
+    """
+
+    def __init__(self, dev, size, pageSize, addr=0x50, addrBytes=None, pollInterval=0):
+        if addrBytes is None:
+            addrBytes = 1 if size <= 2048 else 2
+        self._configure(addr, size, pageSize, addrBytes, pollInterval)
+        self.size = size
+        self.pageSize = pageSize
+        self.addr = addr
+
+    @classmethod
+    def part(cls, dev, name, addr=0x50, pollInterval=0):
+        """Create an EEPROM by part name.
+
+        Args:
+            dev (:obj:`ft4222.FT4222`): Device initialized as I2C master
+            name (str): Part name, one out of :data:`PARTS`
+            addr (int): Slave address
+            pollInterval (int): Microseconds to sleep between two acknowledge polls
+
+        Returns:
+            :obj:`I2CEEPROM`: EEPROM
+
+        """
+        size, pageSize = PARTS[name.upper()]
+        return cls(dev, size, pageSize, addr, pollInterval=pollInterval)
+
+    def read(self, addr, size):
+        """Read from the EEPROM.
+
+        Args:
+            addr (int): Memory address
+            size (int): Number of bytes to read
+
+        Returns:
+            bytes: Data read
+
+        Raises:
+            FT4222DeviceError: on error
+            ValueError: if the range exceeds the EEPROM
+
+        """
+        buf = bytearray(size)
+        self._readinto(addr, buf)
+        return bytes(buf)
+
+    def readinto(self, addr, buffer):
+        """Read from the EEPROM into a writable buffer.
+
+        Args:
+            addr (int): Memory address
+            buffer (bytearray, memoryview): Buffer to fill
+
+        Returns:
+            int: Number of bytes read
+
+        Raises:
+            FT4222DeviceError: on error
+            ValueError: if the range exceeds the EEPROM
+
+        """
+        return self._readinto(addr, buffer)
+
+    def verify(self, addr, data):
+        """Compare the EEPROM content with data.
+
+        Args:
+            addr (int): Memory address
+            data (bytes, bytearray, memoryview): Expected content
+
+        Returns:
+            int: Offset of the first difference, None if equal
+
+        Raises:
+            FT4222DeviceError: on error
+            ValueError: if the range exceeds the EEPROM
+
+        """
+        return self._verifyData(addr, data)
+
+    def write(self, addr, data, verify=True, timeout=0.05):
+        """Write data and wait until the last write cycle is complete.
+
+        Args:
+            addr (int): Memory address
+            data (bytes, bytearray, memoryview): Data to write
+            verify (bool): Read back and compare after writing
+            timeout (float): Seconds the EEPROM may not acknowledge during a write cycle,
+                also the limit for a single write to complete on the bus
+
+        Raises:
+            FT4222DeviceError: on error
+            TimeoutError: if the EEPROM does not acknowledge in time or the I2C
+                controller stays busy, e.g. the bus is held low
+            ValueError: if the range exceeds the EEPROM or the verification fails
+
+        """
+        self._writeData(addr, data, timeout)
+        if verify:
+            offset = self.verify(addr, data)
+            if offset is not None:
+                raise ValueError("verify failed at 0x{:x}".format(addr + offset))
@@ -0,0 +1,329 @@
+#  _____ _____ _____
+# |_    |   __| __  |
+# |_| | |__   |    -|
+# |_|_|_|_____|__|__|
+# MSR Electronics GmbH
+# SPDX-License-Identifier: MIT
+#
+
+"""Flash
+
+Program and verify SPI NOR flashes connected to the SPI master interface.
+
+The geometry and the supported read commands are discovered with JEDEC SFDP (JESD216).
+Erase, program with status polling, read and verify run as a whole in the extension
+without the GIL, so the transfer rate is bound by the bus and the USB round trips::
+
+    dev.spiMaster_Init(Mode.SINGLE, Clock.DIV_2, Cpol.IDLE_LOW, Cpha.CLK_LEADING, SlaveSelect.SS0)
+    flash = SPIFlash(dev)
+    flash.write(0, image)
+"""
+
+import struct
+
+from .ft4222 import _SPIFlash
+from .SPIMaster import Mode
+
+__all__ = ['SFDP', 'SPIFlash']
+
+# 4-byte address variants of the 3-byte address opcodes
+_OPCODES_4B = {0x03: 0x13, 0x0B: 0x0C, 0x3B: 0x3C, 0x6B: 0x6C, 0x02: 0x12, 0x20: 0x21, 0x52: 0x5C, 0xD8: 0xDC}
+
+
+class SFDP:
+    """Parameters of the JEDEC basic flash parameter table.
+
+    Attributes:
+        size (int): Size in bytes
+        pageSize (int): Page size in bytes
+        addrBytes (int): Address bytes, 3 or 4
+        eraseTypes (dict): Opcode per erase block size in bytes
+        reads (dict): ``(opcode, dummyClocks)`` per :obj:`ft4222.SPIMaster.Mode`,
+            for the fast read commands with single line command and address
+        quadEnable (int): Quad enable requirements (DWORD15 bits 22:20), None if the
+            table doesn't tell
+
+    """
+
+    def __init__(self, size, pageSize=256, addrBytes=3, eraseTypes=None, reads=None, quadEnable=None):
+        self.size = size
+        self.pageSize = pageSize
+        self.addrBytes = addrBytes
+        self.eraseTypes = eraseTypes or {4096: 0x20, 65536: 0xD8}
+        self.reads = reads or {Mode.SINGLE: (0x0B, 8)}
+        self.quadEnable = quadEnable
+
+    @classmethod
+    def parse(cls, table):
+        """Parse the JEDEC basic flash parameter table.
+
+        Args:
+            table (bytes): Table as read from the flash, at least 9 DWORDs
+
+        Returns:
+            :obj:`SFDP`: Parameters
+
+        """
+        dw = struct.unpack_from('<{}I'.format(len(table) // 4), table)
+        if dw[1] & 0x80000000:
+            size = (1 << (dw[1] & 0x7FFFFFFF)) // 8
+        else:
+            size = (dw[1] + 1) // 8
+        # 4-byte addresses only, or 3 and 4 bytes and the flash is too large for 3
+        addressing = (dw[0] >> 17) & 0x3
+        addrBytes = 4 if addressing == 0x2 or (addressing == 0x1 and size > 1 << 24) else 3
+        eraseTypes = {}
+        for word in dw[7:9]:
+            for shift in (0, 16):
+                n = (word >> shift) & 0xFF
+                if n:
+                    eraseTypes[1 << n] = (word >> (shift + 8)) & 0xFF
+        if not eraseTypes and dw[0] & 0x3 == 0x1:
+            eraseTypes[4096] = (dw[0] >> 8) & 0xFF
+
+        def clocks(word, shift):
+            return ((word >> shift) & 0x1F) + ((word >> (shift + 5)) & 0x7)
+
+        reads = {Mode.SINGLE: (0x0B, 8)}
+        if dw[0] & (1 << 16):
+            reads[Mode.DUAL] = ((dw[3] >> 8) & 0xFF, clocks(dw[3], 0))
+        if dw[0] & (1 << 22):
+            reads[Mode.QUAD] = ((dw[2] >> 24) & 0xFF, clocks(dw[2], 16))
+        pageSize = 1 << ((dw[10] >> 4) & 0xF) if len(dw) > 10 else 256
+        quadEnable = (dw[14] >> 20) & 0x7 if len(dw) > 14 else None
+        if quadEnable == 0x7:
+            quadEnable = None
+        return cls(size, pageSize, addrBytes, eraseTypes, reads, quadEnable)
+
+
+class SPIFlash(_SPIFlash):
+    """SPI NOR flash.
+
+    The device must be initialized as SPI master with the flash on the selected slave
+    select. For dual and quad reads the interface is switched with
+    :meth:`ft4222.FT4222.spiMaster_SetLines` and back to single mode for all other
+    commands. Quad reads need the quad enable bit of the flash to be set, this is done
+    the way the SFDP table describes it (JESD216B and later). Flashes with an older table
+    only use quad reads if asked for, with the quad enable bit set by the caller.
+
+    Args:
+        dev (:obj:`ft4222.FT4222`): Device initialized as SPI master
+        readMode (:obj:`ft4222.SPIMaster.Mode`): Lines used for reading, None for the
+            fastest mode the flash supports without further setup
+        sfdp (:obj:`SFDP`): Parameters to use instead of reading them from the flash
+        pollInterval (int): Microseconds to sleep between two status polls
+
+    Raises:
+        FT4222DeviceError: on error
+        ValueError: if readMode is not supported by the flash
+
+    """
+
+    def __init__(self, dev, readMode=None, sfdp=None, pollInterval=0):
+        self.jedecId = self._transfer(b'\x9f', 3)
+        self.sfdp = sfdp if sfdp is not None else self.readSFDP()
+        if readMode is None:
+            modes = [m for m in self.sfdp.reads if m != Mode.QUAD or self.sfdp.quadEnable is not None]
+            readMode = max(modes)
+        if readMode not in self.sfdp.reads:
+            raise ValueError("read mode {!r} not supported by the flash".format(readMode))
+        if readMode == Mode.QUAD and self.sfdp.quadEnable is not None:
+            self._enableQuad()
+        readCmd, dummyClocks = self.sfdp.reads[readMode]
+        if dummyClocks % 8:
+            raise ValueError("{} dummy clocks can't be sent".format(dummyClocks))
+        self.readMode = Mode(readMode)
+        self._configure(self.sfdp.addrBytes, self.sfdp.pageSize, self._opcode(readCmd),
+                        dummyClocks // 8, readMode, self._opcode(0x02), pollInterval)
+
+    def _opcode(self, op):
+        return _OPCODES_4B.get(op, op) if self.sfdp.addrBytes == 4 else op
+
+    def _writeStatus(self, data, timeout=0.1):
+        self._transfer(b'\x06')
+        self._transfer(data)
+        self._waitIdle(timeout)
+
+    def _enableQuad(self):
+        """Set the quad enable bit as given by the quad enable requirements of SFDP"""
+        qer = self.sfdp.quadEnable
+        if qer in (0x1, 0x4, 0x5):
+            # bit 1 of status register 2, written together with status register 1
+            sr1 = self.readStatus()
+            sr2 = self._transfer(b'\x35', 1)[0]
+            if not sr2 & 0x02:
+                self._writeStatus(bytes([0x01, sr1, sr2 | 0x02]))
+        elif qer == 0x2:
+            # bit 6 of status register 1
+            sr1 = self.readStatus()
+            if not sr1 & 0x40:
+                self._writeStatus(bytes([0x01, sr1 | 0x40]))
+        elif qer == 0x3:
+            # bit 7 of status register 2, with its own read and write commands
+            sr2 = self._transfer(b'\x3f', 1)[0]
+            if not sr2 & 0x80:
+                self._writeStatus(bytes([0x3E, sr2 | 0x80]))
+        elif qer == 0x6:
+            # bit 1 of status register 2, written on its own
+            sr2 = self._transfer(b'\x35', 1)[0]
+            if not sr2 & 0x02:
+                self._writeStatus(bytes([0x31, sr2 | 0x02]))
+
+    def readSFDP(self):
+        """Read the SFDP tables of the flash.
+
+        Falls back to defaults derived from the JEDEC ID if the flash has no SFDP.
+
+        Returns:
+            :obj:`SFDP`: Parameters
+
+        """
+        def read(addr, size):
+            return self._transfer(bytes([0x5A, (addr >> 16) & 0xFF, (addr >> 8) & 0xFF, addr & 0xFF, 0xFF]), size)
+
+        header = read(0, 8)
+        if header[:4] != b'SFDP':
+            return SFDP(1 << self.jedecId[2] if 0 < self.jedecId[2] < 32 else 0)
+        for i in range(header[6] + 1):
+            param = read(8 + 8 * i, 8)
+            if param[0] == 0x00 and param[7] in (0x00, 0xFF):
+                ptr = param[4] | param[5] << 8 | param[6] << 16
+                return SFDP.parse(read(ptr, param[3] * 4))
+        return SFDP(1 << self.jedecId[2] if 0 < self.jedecId[2] < 32 else 0)
+
+    @property
+    def size(self):
+        """int: Size of the flash in bytes"""
+        return self.sfdp.size
+
+    def readStatus(self):
+        """Read the status register.
+
+        Returns:
+            int: Status register
+
+        """
+        return self._transfer(b'\x05', 1)[0]
+
+    def read(self, addr, size):
+        """Read from the flash.
+
+        Args:
+            addr (int): Address
+            size (int): Number of bytes to read
+
+        Returns:
+            bytes: Data read
+
+        """
+        buf = bytearray(size)
+        self._readinto(addr, buf)
+        return bytes(buf)
+
+    def readinto(self, addr, buffer):
+        """Read from the flash into a writable buffer.
+
+        Args:
+            addr (int): Address
+            buffer (bytearray, memoryview): Buffer to fill
+
+        Returns:
+            int: Number of bytes read
+
+        """
+        return self._readinto(addr, buffer)
+
+    def erase(self, addr, size, timeout=5.0):
+        """Erase a range, always using the largest erase block which fits.
+
+        Args:
+            addr (int): Start address, aligned to the smallest erase block
+            size (int): Number of bytes, rounded up to the smallest erase block
+            timeout (float): Seconds to wait for a single block erase
+
+        Raises:
+            ValueError: if addr is not aligned
+            TimeoutError: if the flash does not get ready in time
+
+        """
+        types = sorted(self.sfdp.eraseTypes.items(), reverse=True)
+        smallest = types[-1][0]
+        if addr % smallest:
+            raise ValueError("address must be aligned to {} bytes".format(smallest))
+        end = addr + -(-size // smallest) * smallest
+        while addr < end:
+            for i, (blockSize, cmd) in enumerate(types):
+                count = (end - addr) // blockSize
+                if addr % blockSize == 0 and count > 0:
+                    if i > 0:
+                        # only up to where the next larger block fits
+                        larger = types[i - 1][0]
+                        count = min(count, (larger - addr % larger) // blockSize)
+                    self._eraseBlocks(self._opcode(cmd), addr, blockSize, count, timeout)
+                    addr += blockSize * count
+                    break
+
+    def chipErase(self, timeout=400.0):
+        """Erase the whole flash.
+
+        Args:
+            timeout (float): Seconds to wait for the erase
+
+        Raises:
+            TimeoutError: if the flash does not get ready in time
+
+        """
+        self._transfer(b'\x06')
+        self._transfer(b'\xc7')
+        self._waitIdle(timeout)
+
+    def program(self, addr, data, timeout=0.1):
+        """Program erased memory, page by page with status polling.
+
+        Args:
+            addr (int): Start address
+            data (bytes, bytearray, memoryview): Data to program
+            timeout (float): Seconds to wait for a single page program
+
+        Raises:
+            TimeoutError: if the flash does not get ready in time
+
+        """
+        self._programData(addr, data, timeout)
+
+    def verify(self, addr, data):
+        """Compare the flash content with data.
+
+        Args:
+            addr (int): Start address
+            data (bytes, bytearray, memoryview): Expected content
+
+        Returns:
+            int: Offset of the first difference, None if equal
+
+        """
+        return self._verifyData(addr, data)
+
+    def write(self, addr, data, erase=True, verify=True):
+        """Erase, program and verify an image.
+
+        All erase blocks touched by the image are erased completely.
+
+        Args:
+            addr (int): Start address, aligned to the smallest erase block if erase is True
+            data (bytes, bytearray, memoryview): Image
+            erase (bool): Erase before programming
+            verify (bool): Read back and compare after programming
+
+        Raises:
+            ValueError: if the verification fails
+            TimeoutError: if the flash does not get ready in time
+
+        """
+        if erase:
+            self.erase(addr, len(data))
+        self.program(addr, data)
+        if verify:
+            offset = self.verify(addr, data)
+            if offset is not None:
+                raise ValueError("verify failed at 0x{:x}".format(addr + offset))
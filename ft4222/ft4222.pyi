@@ -1,8 +1,14 @@
 import enum
-from typing import Any, ClassVar, List, Optional, TypedDict, Union, overload
+from _typeshed import ReadableBuffer, WriteableBuffer
+from typing import Any, Callable, ClassVar, Dict, Iterator, List, Optional, Sequence, Tuple, TypedDict, TypeVar, Union, overload
 
 from ft4222 import GPIO, SPI, I2CMaster, SPIMaster
 
+_S = TypeVar("_S", bound="_RxStream")
+_G = TypeVar("_G", bound="GpioCapture")
+_M = TypeVar("_M", bound="RegisterMap")
+_Q = TypeVar("_Q", bound="CommandQueue")
+
 class FT2XXDeviceError(Exception):
     def __init__(self, msgnum: int) -> None: ...
 
@@ -15,6 +21,15 @@ class SysClock(enum.IntEnum):
     CLK_60: int
     CLK_80: int
 
+class Event(enum.IntFlag):
+    RXCHAR: int
+
+class Purge(enum.IntFlag):
+    RX: int
+    TX: int
+
+TUNING_PROFILES: Dict[str, Dict[str, int]]
+
 class DeviceDetail(TypedDict):
     index: int
     flags: int
@@ -27,9 +42,26 @@ class DeviceDetail(TypedDict):
 
 def createDeviceInfoList() -> int: ...
 def getDeviceInfoDetail(devnum: int, update: bool) -> DeviceDetail: ...
+def listDevices(rescan: bool = ...) -> List[DeviceDetail]: ...
 def openBySerial(serial: Union[str, bytes]) -> FT4222: ...
 def openByDescription(desc: Union[str, bytes]) -> FT4222: ...
 def openByLocation(locId: int) -> FT4222: ...
+def openMany(devices: Sequence[Union[str, bytes, int]]) -> List[Union[FT4222, FT2XXDeviceError]]: ...
+
+class SPIBatch:
+    def __init__(self) -> None: ...
+    def write(
+        self, data: Union[int, ReadableBuffer], isEndTransaction: bool = ...
+    ) -> SPIBatch: ...
+    def read(self, bytesToRead: int, isEndTransaction: bool = ...) -> SPIBatch: ...
+    def readWrite(
+        self, data: Union[int, ReadableBuffer], isEndTransaction: bool = ...
+    ) -> SPIBatch: ...
+    def endTransaction(self) -> SPIBatch: ...
+    def clear(self) -> None: ...
+    @property
+    def readSize(self) -> int: ...
+    def __len__(self) -> int: ...
 
 class FT4222:
     def __init__(self, handle: int, update: bool) -> None: ...
@@ -39,15 +71,29 @@ class FT4222:
     def chipVersion(self) -> int: ...
     @property
     def libVersion(self) -> int: ...
+    def queue(self, notifyFd: int = ..., callback: Optional[Callable[[], Any]] = ...) -> CommandQueue: ...
+    def enableStats(self, enable: bool = ...) -> None: ...
+    @property
+    def statsEnabled(self) -> bool: ...
+    def stats(self) -> Dict[str, Dict[str, Any]]: ...
+    def resetStats(self) -> None: ...
     def setTimeouts(self, read_timeout: int, write_timeout: int) -> None: ...
+    def setLatencyTimer(self, latency: int) -> None: ...
+    def getLatencyTimer(self) -> int: ...
+    def setUSBParameters(self, inTransferSize: int, outTransferSize: int = ...) -> None: ...
+    def purge(self, mask: int = ...) -> None: ...
+    def tune(self, profile: str = ..., **overrides: int) -> Dict[str, int]: ...
     def close(self) -> None: ...
     def setClock(self, clk: SysClock) -> None: ...
     def getClock(self) -> SysClock: ...
     def setSuspendOut(self, enable: bool) -> None: ...
     def setWakeUpInterrut(self, enable: bool) -> None: ...
+    def waitForEvent(
+        self, mask: int = ..., timeout: Optional[float] = ...
+    ) -> bool: ...
     def vendorCmdGet(self, req: Union[str, bytes], bytesToRead: int) -> bytes: ...
     def vendorCmdSet(
-        self, req: Union[str, bytes], data: Union[int, bytes, bytearray]
+        self, req: Union[str, bytes], data: Union[int, ReadableBuffer]
     ) -> None: ...
     def gpio_Init(
         self,
@@ -62,19 +108,53 @@ class FT4222:
     def gpio_SetInputTrigger(
         self, portNum: GPIO.Port, trigger: GPIO.Trigger
     ) -> None: ...
-    def gpio_GetTriggerStatus(self, portNum: GPIO.Port) -> GPIO.Trigger: ...
+    # one gpio_Write, i.e. one USB round trip, per changed pin and sample
+    def gpio_WriteSequence(
+        self, samples: ReadableBuffer, mask: int = ..., interval: int = ...
+    ) -> int: ...
+    def gpio_SetWaveFormMode(self, enable: bool) -> None: ...
+    def gpio_GetTriggerStatus(self, portNum: GPIO.Port) -> int: ...
     def gpio_ReadTriggerQueue(
-        self, portNum: GPIO.Port, readsize: Optional[int]
+        self, portNum: GPIO.Port, readSize: Optional[int] = ...
     ) -> List[GPIO.Trigger]: ...
+    def gpio_ReadTriggerQueue_into(
+        self, portNum: GPIO.Port, buffer: WriteableBuffer
+    ) -> int: ...
+    def gpio_ReadTriggerQueues_into(
+        self, buffer: WriteableBuffer, ports: Sequence[GPIO.Port] = ...
+    ) -> Tuple[int, ...]: ...
     def i2cMaster_Init(self, kbps: int) -> None: ...
     def i2cMaster_Read(self, addr: int, bytesToRead: int) -> bytes: ...
+    def i2cMaster_Read_into(self, addr: int, buffer: WriteableBuffer) -> int: ...
     def i2cMaster_ReadEx(self, addr: int, flag: int, bytesToRead: int) -> bytes: ...
-    def i2cMaster_Write(self, addr: int, data: Union[int, bytes, bytearray]) -> int: ...
+    def i2cMaster_ReadEx_into(
+        self, addr: int, flag: int, buffer: WriteableBuffer
+    ) -> int: ...
+    def i2cMaster_Write(self, addr: int, data: Union[int, ReadableBuffer]) -> int: ...
     def i2cMaster_WriteEx(
-        self, addr: int, flag: int, data: Union[int, bytes, bytearray]
+        self, addr: int, flag: int, data: Union[int, ReadableBuffer]
     ) -> int: ...
+    def i2cMaster_Transfer(
+        self,
+        msgs: Sequence[
+            Union[
+                Tuple[int, Union[int, ReadableBuffer]],
+                Tuple[int, Optional[int], Union[int, ReadableBuffer]],
+            ]
+        ],
+    ) -> bytes: ...
     def i2cMaster_Reset(self) -> None: ...
     def i2cMaster_GetStatus(self) -> I2CMaster.ControllerStatus: ...
+    def i2cSlave_Init(self) -> None: ...
+    def i2cSlave_Reset(self) -> None: ...
+    def i2cSlave_GetAddress(self) -> int: ...
+    def i2cSlave_SetAddress(self, addr: int) -> None: ...
+    def i2cSlave_GetRxStatus(self) -> int: ...
+    def i2cSlave_Read(self, bytesToRead: int) -> bytes: ...
+    def i2cSlave_Read_into(self, buffer: WriteableBuffer) -> int: ...
+    def i2cSlave_Write(self, data: Union[int, ReadableBuffer]) -> int: ...
+    def i2cSlave_SetClockStretch(self, enable: bool) -> None: ...
+    def i2cSlave_SetRespWord(self, responseWord: int) -> None: ...
     def spi_Reset(self) -> None: ...
     def spi_ResetTransaction(self, spiIdx: int) -> None: ...
     def spi_SetDrivingStrength(
@@ -95,22 +175,184 @@ class FT4222:
     def spiMaster_SingleRead(
         self, bytesToRead: int, isEndTransaction: bool
     ) -> bytes: ...
+    def spiMaster_SingleRead_into(
+        self, buffer: WriteableBuffer, isEndTransaction: bool
+    ) -> int: ...
     def spiMaster_SingleWrite(
-        self, data: Union[int, bytes, bytearray], isEndTransaction: bool
+        self, data: Union[int, ReadableBuffer], isEndTransaction: bool
     ) -> None: ...
     def spiMaster_SingleReadWrite(
-        self, data: Union[int, bytes, bytearray], isEndTransaction: bool
+        self, data: Union[int, ReadableBuffer], isEndTransaction: bool
     ) -> bytes: ...
+    def spiMaster_SingleReadWrite_into(
+        self,
+        buffer: WriteableBuffer,
+        data: Union[int, ReadableBuffer],
+        isEndTransaction: bool,
+    ) -> int: ...
     def spiMaster_MultiReadWrite(
         self,
-        singleWrite: Union[int, bytes, bytearray],
-        multiWrite: Union[int, bytes, bytearray],
+        singleWrite: Union[int, ReadableBuffer],
+        multiWrite: Union[int, ReadableBuffer],
         bytesToRead: int,
     ) -> bytes: ...
+    def spiMaster_MultiReadWrite_into(
+        self,
+        buffer: WriteableBuffer,
+        singleWrite: Union[int, ReadableBuffer],
+        multiWrite: Union[int, ReadableBuffer],
+    ) -> int: ...
     def spiMaster_EndTransaction(self) -> None: ...
+    def spiMaster_Batch(self, batch: SPIBatch) -> Tuple[bytes, List[int]]: ...
     def spiSlave_Init(self) -> None: ...
     def spiSlave_InitEx(self, mode: SPIMaster.Mode) -> None: ...
     def spiSlave_Read(self, bytesToRead: int) -> bytes: ...
+    def spiSlave_Read_into(self, buffer: WriteableBuffer) -> int: ...
     def spiSlave_SetMode(self, cpol: SPI.Cpol, cpha: SPI.Cpha) -> None: ...
     def spiSlave_GetRxStatus(self) -> int: ...
-    def spiSlave_Write(self, data: Union[int, bytes, bytearray]) -> int: ...
+    def spiSlave_Write(self, data: Union[int, ReadableBuffer]) -> int: ...
+
+class _RxStream:
+    def __init__(
+        self, dev: FT4222, bufferSize: int = ..., pollInterval: int = ...
+    ) -> None: ...
+    def start(self) -> None: ...
+    def stop(self) -> None: ...
+    def __enter__(self: _S) -> _S: ...
+    def __exit__(self, *exc: Any) -> None: ...
+    @property
+    def running(self) -> bool: ...
+    @property
+    def overruns(self) -> int: ...
+    @property
+    def available(self) -> int: ...
+    def read(self, size: int, timeout: Optional[float] = ...) -> bytes: ...
+    def readinto(
+        self, buffer: WriteableBuffer, timeout: Optional[float] = ...
+    ) -> int: ...
+
+class I2CSlaveStream(_RxStream): ...
+
+class SPISlaveStream(_RxStream): ...
+
+class GpioCapture:
+    RECORD_FORMAT: ClassVar[str]
+    HEADER_FORMAT: ClassVar[str]
+    def __init__(
+        self,
+        dev: FT4222,
+        ports: Sequence[GPIO.Port] = ...,
+        trigger: Optional[GPIO.Trigger] = ...,
+        bufferSize: int = ...,
+        pollInterval: int = ...,
+        file: Optional[str] = ...,
+    ) -> None: ...
+    def start(self) -> None: ...
+    def stop(self) -> None: ...
+    def close(self) -> None: ...
+    def __enter__(self: _G) -> _G: ...
+    def __exit__(self, *exc: Any) -> None: ...
+    @property
+    def running(self) -> bool: ...
+    @property
+    def overruns(self) -> int: ...
+    @property
+    def available(self) -> int: ...
+    def read(
+        self, size: Optional[int] = ..., timeout: Optional[float] = ...
+    ) -> List[Tuple[int, GPIO.Trigger, int]]: ...
+    def readinto(
+        self, buffer: WriteableBuffer, timeout: Optional[float] = ...
+    ) -> int: ...
+
+class _SPIFlash:
+    def __init__(self, dev: FT4222, *args: Any, **kwargs: Any) -> None: ...
+    def _configure(
+        self,
+        addrBytes: int,
+        pageSize: int,
+        readCmd: int,
+        readDummy: int,
+        readLines: SPIMaster.Mode,
+        programCmd: int,
+        pollInterval: int,
+    ) -> None: ...
+    def _transfer(self, data: Union[int, ReadableBuffer], bytesToRead: int = ...) -> bytes: ...
+    def _readinto(self, addr: int, buffer: WriteableBuffer) -> int: ...
+    def _programData(self, addr: int, data: Union[int, ReadableBuffer], timeout: float) -> None: ...
+    def _eraseBlocks(
+        self, cmd: int, addr: int, blockSize: int, count: int, timeout: float
+    ) -> None: ...
+    def _waitIdle(self, timeout: float) -> None: ...
+    def _verifyData(self, addr: int, data: Union[int, ReadableBuffer]) -> Optional[int]: ...
+
+class _I2CEEPROM:
+    def __init__(self, dev: FT4222, *args: Any, **kwargs: Any) -> None: ...
+    def _configure(
+        self, addr: int, size: int, pageSize: int, addrBytes: int, pollInterval: int
+    ) -> None: ...
+    def _readinto(self, memAddr: int, buffer: WriteableBuffer) -> int: ...
+    def _writeData(self, memAddr: int, data: Union[int, ReadableBuffer], timeout: float) -> None: ...
+    def _verifyData(self, memAddr: int, data: Union[int, ReadableBuffer]) -> Optional[int]: ...
+
+class RegisterMap:
+    def __init__(
+        self,
+        dev: FT4222,
+        registers: Sequence[Tuple[Any, ...]],
+        slaveAddr: Optional[int] = ...,
+        addrWidth: int = ...,
+        addrUnit: int = ...,
+        byteorder: str = ...,
+        readFlag: int = ...,
+        writeFlag: int = ...,
+    ) -> None: ...
+    def fetch(self, names: Optional[Sequence[str]] = ...) -> None: ...
+    def flush(self) -> None: ...
+    def invalidate(self, names: Optional[Sequence[str]] = ...) -> None: ...
+    def get(self, name: str) -> int: ...
+    def set(self, name: str, value: int) -> None: ...
+    def update(self, name: str, mask: int, value: int) -> None: ...
+    @property
+    def dirty(self) -> List[str]: ...
+    def __getitem__(self, name: str) -> int: ...
+    def __setitem__(self, name: str, value: int) -> None: ...
+    def __contains__(self, name: object) -> bool: ...
+    def __iter__(self) -> Iterator[str]: ...
+    def __len__(self) -> int: ...
+    def __enter__(self: _M) -> _M: ...
+    def __exit__(self, *exc: Any) -> None: ...
+
+class CommandFuture:
+    def done(self) -> bool: ...
+    def result(self, timeout: Optional[float] = ...) -> Any: ...
+    def exception(self, timeout: Optional[float] = ...) -> Optional[BaseException]: ...
+
+class CommandQueue:
+    def __init__(self, dev: FT4222, notifyFd: int = ..., callback: Optional[Callable[[], Any]] = ...) -> None: ...
+    def spiMaster_SingleRead(self, bytesToRead: int, isEndTransaction: bool) -> CommandFuture: ...
+    def spiMaster_SingleRead_into(self, buffer: WriteableBuffer, isEndTransaction: bool) -> CommandFuture: ...
+    def spiMaster_SingleWrite(self, data: Union[int, ReadableBuffer], isEndTransaction: bool) -> CommandFuture: ...
+    def spiMaster_SingleReadWrite(self, data: Union[int, ReadableBuffer], isEndTransaction: bool) -> CommandFuture: ...
+    def spiMaster_SingleReadWrite_into(
+        self, buffer: WriteableBuffer, data: Union[int, ReadableBuffer], isEndTransaction: bool
+    ) -> CommandFuture: ...
+    def spiMaster_MultiReadWrite(
+        self, singleWrite: Union[int, ReadableBuffer], multiWrite: Union[int, ReadableBuffer], bytesToRead: int
+    ) -> CommandFuture: ...
+    def i2cMaster_Read(self, addr: int, bytesToRead: int) -> CommandFuture: ...
+    def i2cMaster_Read_into(self, addr: int, buffer: WriteableBuffer) -> CommandFuture: ...
+    def i2cMaster_Write(self, addr: int, data: Union[int, ReadableBuffer]) -> CommandFuture: ...
+    def i2cMaster_ReadEx(self, addr: int, flag: int, bytesToRead: int) -> CommandFuture: ...
+    def i2cMaster_ReadEx_into(self, addr: int, flag: int, buffer: WriteableBuffer) -> CommandFuture: ...
+    def i2cMaster_WriteEx(self, addr: int, flag: int, data: Union[int, ReadableBuffer]) -> CommandFuture: ...
+    def i2cMaster_GetStatus(self) -> CommandFuture: ...
+    def gpio_Read(self, portNum: GPIO.Port) -> CommandFuture: ...
+    def gpio_Write(self, portNum: GPIO.Port, value: bool) -> CommandFuture: ...
+    def call(self, fn: Callable[..., Any], *args: Any, **kwargs: Any) -> CommandFuture: ...
+    def __getattr__(self, name: str) -> Callable[..., CommandFuture]: ...
+    @property
+    def pending(self) -> int: ...
+    def close(self) -> None: ...
+    def __enter__(self: _Q) -> _Q: ...
+    def __exit__(self, *exc: Any) -> None: ...
@@ -11,17 +11,167 @@ from __future__ import absolute_import
 from ft4222.cftd2xx cimport *
 from ft4222.clibft4222 cimport *
 from cpython.array cimport array, resize
+from cpython.bytes cimport PyBytes_FromStringAndSize, PyBytes_AS_STRING
 from libc.stdio cimport printf
-from enum import IntEnum
+from libc.string cimport memcmp, memcpy, memset
+from libc.stdlib cimport malloc, calloc, realloc, free
+from enum import IntEnum, IntFlag
+import collections
+import mmap
+import struct
+import threading
+import time
 from .GPIO import Dir, Trigger
 from .I2CMaster import ControllerStatus
 
-IF UNAME_SYSNAME == "Windows":
-    cdef extern from "<malloc.h>" nogil:
-        void *alloca(size_t size)
-ELSE:
-    cdef extern from "<alloca.h>" nogil:
-        void *alloca(size_t size)
+cdef extern from "<string.h>" nogil:
+    size_t strnlen(const char* s, size_t maxlen)
+
+cdef extern from *:
+    """
+    /* sleep, monotonic clock and the event object signaled by FT4222_SetEventNotification */
+    #include <stdint.h>
+    #if defined(_WIN32)
+    #include <windows.h>
+    #else
+    #include <pthread.h>
+    #include <time.h>
+    #include <unistd.h>
+    #endif
+    #include "ftd2xx.h"
+
+    #if defined(_WIN32)
+    static void ft4222_sleep_us(uint32_t us) { Sleep((us + 999) / 1000); }
+
+    static uint64_t ft4222_monotonic_ns(void) {
+        LARGE_INTEGER count, freq;
+        QueryPerformanceCounter(&count);
+        QueryPerformanceFrequency(&freq);
+        return (uint64_t)(count.QuadPart / freq.QuadPart) * 1000000000ULL +
+               (uint64_t)(count.QuadPart % freq.QuadPart) * 1000000000ULL / (uint64_t)freq.QuadPart;
+    }
+
+    /* auto-reset event object, created on first use */
+    typedef struct { HANDLE handle; } ft4222_event;
+    static void ft4222_event_init(ft4222_event* ev) { ev->handle = NULL; }
+    static void ft4222_event_destroy(ft4222_event* ev) { if (ev->handle != NULL) CloseHandle(ev->handle); }
+
+    static void* ft4222_event_param(ft4222_event* ev) {
+        if (ev->handle == NULL)
+            ev->handle = CreateEventA(NULL, FALSE, FALSE, NULL);
+        return ev->handle;
+    }
+
+    static int ft4222_event_wait(ft4222_event* ev, double timeout) {
+        return WaitForSingleObject(ev->handle, timeout < 0 ? INFINITE : (DWORD)(timeout * 1000)) == WAIT_OBJECT_0;
+    }
+    #else
+    static void ft4222_sleep_us(uint32_t us) { usleep(us); }
+
+    static uint64_t ft4222_monotonic_ns(void) {
+        struct timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return (uint64_t)ts.tv_sec * 1000000000ULL + (uint64_t)ts.tv_nsec;
+    }
+
+    /* substitute for the Windows event object, see WinTypes.h */
+    typedef EVENT_HANDLE ft4222_event;
+
+    static void ft4222_event_init(ft4222_event* ev) {
+        pthread_mutex_init(&ev->eMutex, NULL);
+        pthread_cond_init(&ev->eCondVar, NULL);
+        ev->iVar = 0;
+    }
+
+    static void ft4222_event_destroy(ft4222_event* ev) {
+        pthread_cond_destroy(&ev->eCondVar);
+        pthread_mutex_destroy(&ev->eMutex);
+    }
+
+    static void* ft4222_event_param(ft4222_event* ev) { return ev; }
+
+    static int ft4222_event_wait(ft4222_event* ev, double timeout) {
+        struct timespec ts;
+        int rc = 0;
+        int signaled;
+        if (timeout >= 0) {
+            clock_gettime(CLOCK_REALTIME, &ts);
+            ts.tv_sec += (long)timeout;
+            ts.tv_nsec += (long)((timeout - (long)timeout) * 1e9);
+            if (ts.tv_nsec >= 1000000000L) {
+                ts.tv_sec += 1;
+                ts.tv_nsec -= 1000000000L;
+            }
+        }
+        pthread_mutex_lock(&ev->eMutex);
+        /* any error, not just ETIMEDOUT, ends the wait */
+        while (ev->iVar == 0 && rc == 0) {
+            if (timeout < 0)
+                rc = pthread_cond_wait(&ev->eCondVar, &ev->eMutex);
+            else
+                rc = pthread_cond_timedwait(&ev->eCondVar, &ev->eMutex, &ts);
+        }
+        signaled = ev->iVar != 0;
+        ev->iVar = 0;
+        pthread_mutex_unlock(&ev->eMutex);
+        return signaled;
+    }
+    #endif
+
+    /* counter of the users of a handle, the top bit is set while it is closed */
+    #define FT4222_CLOSING ((size_t)1 << (sizeof(size_t) * 8 - 1))
+    #if defined(_MSC_VER) && defined(_WIN64)
+    #define ft4222_atomic_add(p, v) ((size_t)InterlockedExchangeAdd64((LONG64 volatile*)(p), (LONG64)(v)) + (size_t)(v))
+    #define ft4222_atomic_cas(p, e, d) \
+        ((size_t)InterlockedCompareExchange64((LONG64 volatile*)(p), (LONG64)(d), (LONG64)(e)) == (size_t)(e))
+    #elif defined(_MSC_VER)
+    #define ft4222_atomic_add(p, v) ((size_t)InterlockedExchangeAdd((LONG volatile*)(p), (LONG)(v)) + (size_t)(v))
+    #define ft4222_atomic_cas(p, e, d) \
+        ((size_t)InterlockedCompareExchange((LONG volatile*)(p), (LONG)(d), (LONG)(e)) == (size_t)(e))
+    #else
+    #define ft4222_atomic_add(p, v) __atomic_add_fetch((p), (v), __ATOMIC_SEQ_CST)
+    static int ft4222_atomic_cas(size_t* p, size_t e, size_t d) {
+        return __atomic_compare_exchange_n(p, &e, d, 0, __ATOMIC_SEQ_CST, __ATOMIC_SEQ_CST);
+    }
+    #endif
+
+    /* call statistics, updated by the user threads and the stream and capture threads at once */
+    #if defined(_MSC_VER)
+    #define ft4222_stats_add(p, v) ((void)InterlockedExchangeAdd64((LONG64 volatile*)(p), (LONG64)(v)))
+    static __inline void ft4222_stats_max(uint64_t* p, uint64_t v) {
+        uint64_t cur = *(volatile uint64_t*)p;
+        while (v > cur) {
+            uint64_t prev = (uint64_t)InterlockedCompareExchange64((LONG64 volatile*)p, (LONG64)v, (LONG64)cur);
+            if (prev == cur)
+                break;
+            cur = prev;
+        }
+    }
+    #else
+    #define ft4222_stats_add(p, v) ((void)__atomic_fetch_add((p), (v), __ATOMIC_RELAXED))
+    static void ft4222_stats_max(uint64_t* p, uint64_t v) {
+        uint64_t cur = __atomic_load_n(p, __ATOMIC_RELAXED);
+        while (v > cur && !__atomic_compare_exchange_n(p, &cur, v, 1, __ATOMIC_RELAXED, __ATOMIC_RELAXED))
+            ;
+    }
+    #endif
+    """
+    void _sleep_us "ft4222_sleep_us" (uint32 us) noexcept nogil
+    uint64_t _monotonic_ns "ft4222_monotonic_ns" () noexcept nogil
+
+    ctypedef struct _Event "ft4222_event":
+        pass
+    void _event_init "ft4222_event_init" (_Event* ev) noexcept nogil
+    void _event_destroy "ft4222_event_destroy" (_Event* ev) noexcept nogil
+    void* _event_param "ft4222_event_param" (_Event* ev) noexcept nogil
+    bint _event_wait "ft4222_event_wait" (_Event* ev, double timeout) noexcept nogil
+
+    size_t _CLOSING "FT4222_CLOSING"
+    size_t _atomic_add "ft4222_atomic_add" (size_t* p, size_t v) noexcept nogil
+    bint _atomic_cas "ft4222_atomic_cas" (size_t* p, size_t expected, size_t desired) noexcept nogil
+
+    void _stats_add "ft4222_stats_add" (uint64_t* p, uint64_t v) noexcept nogil
+    void _stats_max "ft4222_stats_max" (uint64_t* p, uint64_t v) noexcept nogil
 
 
 __ftd2xx_msgs = ['OK', 'INVALID_HANDLE', 'DEVICE_NOT_FOUND', 'DEVICE_NOT_OPENED',
@@ -88,10 +238,188 @@ class SysClock(IntEnum):
     CLK_48 = 2
     CLK_80 = 3
 
+class Event(IntFlag):
+    """Event notification mask
+
+    Attributes:
+        RXCHAR: Data received in SPI slave or I2C slave mode, or a GPIO trigger occurred
+
+    """
+    RXCHAR = FT4222_EVENT_RXCHAR
+
+class Purge(IntFlag):
+    """Buffers to purge
+
+    Attributes:
+        RX: Receive buffer
+        TX: Transmit buffer
+
+    """
+    RX = FT_PURGE_RX
+    TX = FT_PURGE_TX
+
+#: USB transfer settings applied by :meth:`FT4222.tune`. Each profile holds the latency timer
+#: in ms, the USB in and out transfer sizes in bytes and the read and write timeouts in ms.
+TUNING_PROFILES = {
+    # flush small replies right away, short USB requests
+    'low_latency': {'latency': 2, 'inTransferSize': 512, 'outTransferSize': 512,
+                    'readTimeout': 100, 'writeTimeout': 100},
+    # settings the driver starts with, timeouts of 0 wait forever
+    'default': {'latency': 16, 'inTransferSize': 4096, 'outTransferSize': 4096,
+                'readTimeout': 0, 'writeTimeout': 0},
+    # large USB requests for throughput, long timeouts for large transfers
+    'bulk': {'latency': 16, 'inTransferSize': 65536, 'outTransferSize': 65536,
+             'readTimeout': 5000, 'writeTimeout': 5000},
+}
+
+cdef const uint8[::1] _data_view(data, name):
+    """Get a read-only view on data, which can either be an int or any
+    object supporting the buffer protocol"""
+    if isinstance(data, int):
+        return bytes([data])
+    try:
+        return data
+    except TypeError:
+        raise TypeError("the {} argument must be of type 'int' or a bytes-like object".format(name)) from None
+
+cdef inline _concat(uint8* dest, const uint8[::1] a, const uint8[::1] b):
+    """Copy a and b back to back to dest"""
+    if a.shape[0] > 0:
+        memcpy(dest, &a[0], a.shape[0])
+    if b.shape[0] > 0:
+        memcpy(dest + a.shape[0], &b[0], b.shape[0])
+
+
+# Call statistics, one entry per instrumented library function. Bucket i of the
+# latency histogram counts calls which took [2**i, 2**(i+1)) ns.
+DEF STATS_BUCKETS = 40
+
+cdef enum _StatsOp:
+    _OP_GPIO_INIT
+    _OP_GPIO_READ
+    _OP_GPIO_WRITE
+    _OP_GPIO_SETINPUTTRIGGER
+    _OP_GPIO_GETTRIGGERSTATUS
+    _OP_GPIO_READTRIGGERQUEUE
+    _OP_GPIO_SETWAVEFORMMODE
+    _OP_I2CMASTER_INIT
+    _OP_I2CMASTER_READ
+    _OP_I2CMASTER_WRITE
+    _OP_I2CMASTER_READEX
+    _OP_I2CMASTER_WRITEEX
+    _OP_I2CMASTER_RESET
+    _OP_I2CMASTER_GETSTATUS
+    _OP_I2CSLAVE_INIT
+    _OP_I2CSLAVE_RESET
+    _OP_I2CSLAVE_GETADDRESS
+    _OP_I2CSLAVE_SETADDRESS
+    _OP_I2CSLAVE_GETRXSTATUS
+    _OP_I2CSLAVE_READ
+    _OP_I2CSLAVE_WRITE
+    _OP_I2CSLAVE_SETCLOCKSTRETCH
+    _OP_I2CSLAVE_SETRESPWORD
+    _OP_SPI_RESET
+    _OP_SPI_RESETTRANSACTION
+    _OP_SPI_SETDRIVINGSTRENGTH
+    _OP_SPIMASTER_INIT
+    _OP_SPIMASTER_SETLINES
+    _OP_SPIMASTER_SINGLEREAD
+    _OP_SPIMASTER_SINGLEWRITE
+    _OP_SPIMASTER_SINGLEREADWRITE
+    _OP_SPIMASTER_MULTIREADWRITE
+    _OP_SPIMASTER_ENDTRANSACTION
+    _OP_SPISLAVE_INIT
+    _OP_SPISLAVE_INITEX
+    _OP_SPISLAVE_SETMODE
+    _OP_SPISLAVE_GETRXSTATUS
+    _OP_SPISLAVE_READ
+    _OP_SPISLAVE_WRITE
+    _OP_VENDORCMDGET
+    _OP_VENDORCMDSET
+    _OP_COUNT
+
+_stats_op_names = [
+    'GPIO_Init',
+    'GPIO_Read',
+    'GPIO_Write',
+    'GPIO_SetInputTrigger',
+    'GPIO_GetTriggerStatus',
+    'GPIO_ReadTriggerQueue',
+    'GPIO_SetWaveFormMode',
+    'I2CMaster_Init',
+    'I2CMaster_Read',
+    'I2CMaster_Write',
+    'I2CMaster_ReadEx',
+    'I2CMaster_WriteEx',
+    'I2CMaster_Reset',
+    'I2CMaster_GetStatus',
+    'I2CSlave_Init',
+    'I2CSlave_Reset',
+    'I2CSlave_GetAddress',
+    'I2CSlave_SetAddress',
+    'I2CSlave_GetRxStatus',
+    'I2CSlave_Read',
+    'I2CSlave_Write',
+    'I2CSlave_SetClockStretch',
+    'I2CSlave_SetRespWord',
+    'SPI_Reset',
+    'SPI_ResetTransaction',
+    'SPI_SetDrivingStrength',
+    'SPIMaster_Init',
+    'SPIMaster_SetLines',
+    'SPIMaster_SingleRead',
+    'SPIMaster_SingleWrite',
+    'SPIMaster_SingleReadWrite',
+    'SPIMaster_MultiReadWrite',
+    'SPIMaster_EndTransaction',
+    'SPISlave_Init',
+    'SPISlave_InitEx',
+    'SPISlave_SetMode',
+    'SPISlave_GetRxStatus',
+    'SPISlave_Read',
+    'SPISlave_Write',
+    'VendorCmdGet',
+    'VendorCmdSet',
+]
+
+cdef struct _OpStats:
+    uint64_t calls
+    uint64_t errors
+    uint64_t bytes
+    uint64_t totalNs
+    uint64_t maxNs
+    uint64_t histogram[STATS_BUCKETS]
+
+cdef inline uint64_t _stats_begin(_OpStats* stats) noexcept nogil:
+    return _monotonic_ns() if stats != NULL else 0
+
+cdef inline void _stats_end(_OpStats* stats, _StatsOp op, uint64_t t0, int status, size_t nbytes) noexcept nogil:
+    """Account a call started at t0, stats is NULL while instrumentation is disabled"""
+    if stats == NULL:
+        return
+    cdef uint64_t dt = _monotonic_ns() - t0
+    cdef uint64_t v = dt
+    cdef int bucket = 0
+    cdef _OpStats* s = &stats[<int>op]
+    while v > 1 and bucket < STATS_BUCKETS - 1:
+        v >>= 1
+        bucket += 1
+    _stats_add(&s.calls, 1)
+    if status != 0:
+        _stats_add(&s.errors, 1)
+    else:
+        _stats_add(&s.bytes, nbytes)
+    _stats_add(&s.totalNs, dt)
+    _stats_max(&s.maxNs, dt)
+    _stats_add(&s.histogram[bucket], 1)
+
 def createDeviceInfoList():
     """Create the internal device info list and return number of entries"""
-    cdef DWORD nb
-    status = FT_CreateDeviceInfoList(&nb)
+    cdef:
+        DWORD nb
+        FT_STATUS status
+    with nogil:
+        status = FT_CreateDeviceInfoList(&nb)
     if status == FT_OK:
         return nb
     raise FT2XXDeviceError, status
@@ -104,20 +432,88 @@ def getDeviceInfoDetail(devnum=0, update=True):
         FT_HANDLE h
         char n[MAX_DESCRIPTION_SIZE]
         char d[MAX_DESCRIPTION_SIZE]
+        DWORD cdevnum = devnum
+        FT_STATUS status
     # createDeviceInfoList is slow, only run if update is True
     if update: createDeviceInfoList()
-    status = FT_GetDeviceInfoDetail(devnum, &f, &t, &i, &l, n, d, &h)
+    with nogil:
+        status = FT_GetDeviceInfoDetail(cdevnum, &f, &t, &i, &l, n, d, &h)
     if status == FT_OK:
         return {'index': devnum, 'flags': f, 'type': t,
                 'id': i, 'location': l, 'serial': n,
                 'description': d, 'handle': <size_t>h}
     raise FT2XXDeviceError, status
 
+# snapshot of the device info list, see listDevices()
+cdef FT_DEVICE_LIST_INFO_NODE* _devices = NULL
+cdef DWORD _numDevices = 0
+cdef bint _devicesValid = False
+_devicesLock = threading.Lock()
+
+cdef _scanDevices():
+    """Replace the device snapshot by a new one, _devicesLock must be held"""
+    global _devices, _numDevices, _devicesValid
+    cdef:
+        DWORD nb
+        FT_DEVICE_LIST_INFO_NODE* nodes
+        FT_STATUS status
+    with nogil:
+        status = FT_CreateDeviceInfoList(&nb)
+    if status != FT_OK:
+        raise FT2XXDeviceError, status
+    nodes = <FT_DEVICE_LIST_INFO_NODE*>malloc(max(nb, 1) * sizeof(FT_DEVICE_LIST_INFO_NODE))
+    if nodes == NULL:
+        raise MemoryError()
+    if nb > 0:
+        with nogil:
+            status = FT_GetDeviceInfoList(nodes, &nb)
+        if status != FT_OK:
+            free(nodes)
+            raise FT2XXDeviceError, status
+    free(_devices)
+    _devices = nodes
+    _numDevices = nb
+    _devicesValid = True
+
+def listDevices(rescan=False):
+    """Get the details of all devices.
+
+    The device info list is read with a single call and kept as a snapshot. Further calls
+    return the snapshot without touching the USB bus, until rescan is True. A running
+    :class:`DeviceWatcher` refreshes the snapshot whenever an adapter is added or removed.
+
+    Args:
+        rescan (bool): Rebuild the device info list instead of using the snapshot
+
+    Returns:
+        :obj:`list` of :obj:`dict`: Same entries as returned by :func:`getDeviceInfoDetail`
+
+    Raises:
+        FT2XXDeviceError: on error
+
+    """
+    cdef FT_DEVICE_LIST_INFO_NODE* node
+    cdef DWORD i
+    with _devicesLock:
+        if rescan or not _devicesValid:
+            _scanDevices()
+        res = []
+        for i in range(_numDevices):
+            node = &_devices[i]
+            res.append({'index': i, 'flags': node.Flags, 'type': node.Type,
+                        'id': node.ID, 'location': node.LocId,
+                        'serial': node.SerialNumber[:strnlen(node.SerialNumber, sizeof(node.SerialNumber))],
+                        'description': node.Description[:strnlen(node.Description, sizeof(node.Description))],
+                        'handle': <size_t>node.ftHandle})
+        return res
+
 def openBySerial(serial):
     """Open a handle to a usb device by serial number"""
     cdef FT_HANDLE handle
+    cdef FT_STATUS status
     cdef char* cserial = serial
-    status = FT_OpenEx(<PVOID>cserial, FT_OPEN_BY_SERIAL_NUMBER, &handle)
+    with nogil:
+        status = FT_OpenEx(<PVOID>cserial, FT_OPEN_BY_SERIAL_NUMBER, &handle)
     if status == FT_OK:
         return FT4222(<uintptr_t>handle, update=False)
     raise FT2XXDeviceError, status
@@ -138,8 +534,10 @@ def openByDescription(desc):
     if isinstance(desc, str):
         desc = desc.encode('utf-8')
     cdef FT_HANDLE handle
+    cdef FT_STATUS status
     cdef char* cdesc = desc
-    status = FT_OpenEx(<PVOID>cdesc, FT_OPEN_BY_DESCRIPTION, &handle)
+    with nogil:
+        status = FT_OpenEx(<PVOID>cdesc, FT_OPEN_BY_DESCRIPTION, &handle)
     if status == FT_OK:
         #printf("handle: %d\n", handle)
         return FT4222(<uintptr_t>handle, update=False)
@@ -159,16 +557,292 @@ def openByLocation(locId):
 
     """
     cdef FT_HANDLE handle
-    status = FT_OpenEx(<PVOID><uintptr_t>locId, FT_OPEN_BY_LOCATION, &handle)
+    cdef FT_STATUS status
+    cdef uintptr_t clocId = locId
+    with nogil:
+        status = FT_OpenEx(<PVOID>clocId, FT_OPEN_BY_LOCATION, &handle)
     if status == FT_OK:
         return FT4222(<uintptr_t>handle, update=False)
     raise FT2XXDeviceError, status
 
 
+cdef struct _OpenRequest:
+    PVOID arg
+    DWORD flags
+    FT_HANDLE handle
+    FT_STATUS status
+    FT4222_STATUS versionStatus
+    FT4222_Version version
+
+cdef class _Opener:
+    """Open requests shared with the threads of openMany"""
+    cdef _OpenRequest* _requests
+
+    def __cinit__(self, size_t count):
+        self._requests = <_OpenRequest*>calloc(max(count, <size_t>1), sizeof(_OpenRequest))
+        if self._requests == NULL:
+            raise MemoryError()
+
+    def __dealloc__(self):
+        free(self._requests)
+
+    def _run(self, size_t i):
+        cdef _OpenRequest* r = &self._requests[i]
+        with nogil:
+            r.status = FT_OpenEx(r.arg, r.flags, &r.handle)
+            if r.status == FT_OK:
+                r.versionStatus = FT4222_GetVersion(r.handle, &r.version)
+
+def openMany(devices):
+    """Open several usb devices at once.
+
+    The devices are opened and queried for their version concurrently, one thread per
+    device, which cuts the startup time of racks with many adapters to about the time
+    of a single open.
+
+    Args:
+        devices (list): Serial numbers (bytes, str) and/or location ids (int)
+
+    Returns:
+        list: An opened :obj:`FT4222` or the :obj:`FT2XXDeviceError` which occurred,
+        per device in the order of devices
+
+    """
+    devices = list(devices)
+    cdef size_t i, n = len(devices)
+    cdef _Opener opener = _Opener(n)
+    cdef _OpenRequest* r
+    cdef FT4222 dev
+    keys = []
+    for i in range(n):
+        r = &opener._requests[i]
+        key = devices[i]
+        if isinstance(key, int):
+            r.arg = <PVOID><uintptr_t>key
+            r.flags = FT_OPEN_BY_LOCATION
+        else:
+            if isinstance(key, str):
+                key = key.encode('utf-8')
+            # keep the serial alive until the threads are done
+            keys.append(key)
+            r.arg = <PVOID><char*>key
+            r.flags = FT_OPEN_BY_SERIAL_NUMBER
+    threads = [threading.Thread(target=opener._run, args=(i,), name='openMany') for i in range(n)]
+    for t in threads:
+        t.start()
+    for t in threads:
+        t.join()
+    res = []
+    for i in range(n):
+        r = &opener._requests[i]
+        if r.status != FT_OK:
+            res.append(FT2XXDeviceError(r.status))
+            continue
+        dev = FT4222.__new__(FT4222)
+        dev._handle = r.handle
+        if r.versionStatus == FT4222_OK:
+            dev._chip_version = r.version.chipVersion
+            dev._dll_version = r.version.dllVersion
+        res.append(dev)
+    return res
+
+
+cdef struct _I2CMsg:
+    uint16 addr
+    uint8 flag
+    bint read
+    uint16 size
+    uint8* data
+
+cdef enum _SPIBatchOpKind:
+    _SPI_BATCH_WRITE
+    _SPI_BATCH_READ
+    _SPI_BATCH_READWRITE
+    _SPI_BATCH_END
+
+cdef struct _SPIBatchOp:
+    _SPIBatchOpKind kind
+    bint isEndTransaction
+    size_t size
+    size_t writeOffset
+    size_t readOffset
+
+cdef class SPIBatch:
+    """Pre-compiled sequence of SPI master operations in single mode.
+
+    The operations are recorded once and can be executed any number of times with
+    :obj:`FT4222.spiMaster_Batch`, which runs the whole sequence in one loop without
+    the GIL. All builder methods return the batch itself, so calls can be chained::
+
+        batch = ft4222.SPIBatch().write(b'\x9f').read(3, True)
+        data, offsets = dev.spiMaster_Batch(batch)
+
+    A batch can't be modified while it is being executed.
+    """
+    cdef _SPIBatchOp* _ops
+    cdef size_t _nops
+    cdef size_t _opsCapacity
+    cdef uint8* _wdata
+    cdef size_t _wsize
+    cdef size_t _wCapacity
+    cdef size_t _rsize
+    cdef size_t _nreads
+    cdef size_t _executing
+
+    def __cinit__(self):
+        self._ops = NULL
+        self._nops = self._opsCapacity = 0
+        self._wdata = NULL
+        self._wsize = self._wCapacity = 0
+        self._rsize = 0
+        self._nreads = 0
+        self._executing = 0
+
+    def __dealloc__(self):
+        free(self._ops)
+        free(self._wdata)
+
+    cdef int _checkIdle(self) except -1:
+        if self._executing:
+            raise RuntimeError("batch is being executed")
+        return 0
+
+    cdef _SPIBatchOp* _append(self, _SPIBatchOpKind kind, size_t size, bint isEndTransaction) except NULL:
+        cdef size_t capacity
+        cdef void* p
+        self._checkIdle()
+        if self._nops == self._opsCapacity:
+            capacity = max(<size_t>16, 2 * self._opsCapacity)
+            p = realloc(self._ops, capacity * sizeof(_SPIBatchOp))
+            if p == NULL:
+                raise MemoryError()
+            self._ops = <_SPIBatchOp*>p
+            self._opsCapacity = capacity
+        cdef _SPIBatchOp* op = &self._ops[self._nops]
+        op.kind = kind
+        op.size = size
+        op.isEndTransaction = isEndTransaction
+        op.writeOffset = self._wsize
+        op.readOffset = self._rsize
+        self._nops += 1
+        return op
+
+    cdef _appendData(self, data):
+        cdef const uint8[::1] view = _data_view(data, 'data')
+        cdef size_t size = view.shape[0]
+        cdef size_t capacity
+        cdef void* p
+        self._checkIdle()
+        if self._wsize + size > self._wCapacity:
+            capacity = max(<size_t>256, 2 * self._wCapacity, self._wsize + size)
+            p = realloc(self._wdata, capacity)
+            if p == NULL:
+                raise MemoryError()
+            self._wdata = <uint8*>p
+            self._wCapacity = capacity
+        if size > 0:
+            memcpy(self._wdata + self._wsize, &view[0], size)
+        return size
+
+    def write(self, data, bint isEndTransaction=False):
+        """Append a write to the batch
+
+        Args:
+            data (bytes-like, int): Data to write to slave
+            isEndTransaction (bool): If True the slave select pin will be raised at the end
+
+        Returns:
+            :obj:`SPIBatch`: The batch itself
+
+        """
+        size = self._appendData(data)
+        self._append(_SPI_BATCH_WRITE, size, isEndTransaction)
+        self._wsize += size
+        return self
+
+    def read(self, size_t bytesToRead, bint isEndTransaction=False):
+        """Append a read to the batch
+
+        Args:
+            bytesToRead (int): Number of bytes to read
+            isEndTransaction (bool): If True the slave select pin will be raised at the end
+
+        Returns:
+            :obj:`SPIBatch`: The batch itself
+
+        """
+        self._append(_SPI_BATCH_READ, bytesToRead, isEndTransaction)
+        self._rsize += bytesToRead
+        self._nreads += 1
+        return self
+
+    def readWrite(self, data, bint isEndTransaction=False):
+        """Append a full duplex transfer to the batch, the read data is part of the result
+
+        Args:
+            data (bytes-like, int): Data to write to slave
+            isEndTransaction (bool): If True the slave select pin will be raised at the end
+
+        Returns:
+            :obj:`SPIBatch`: The batch itself
+
+        """
+        size = self._appendData(data)
+        self._append(_SPI_BATCH_READWRITE, size, isEndTransaction)
+        self._wsize += size
+        self._rsize += size
+        self._nreads += 1
+        return self
+
+    def endTransaction(self):
+        """Append the end of the current transaction to the batch
+
+        Returns:
+            :obj:`SPIBatch`: The batch itself
+
+        """
+        self._append(_SPI_BATCH_END, 0, True)
+        return self
+
+    def clear(self):
+        """Remove all operations from the batch"""
+        self._checkIdle()
+        self._nops = 0
+        self._wsize = 0
+        self._rsize = 0
+        self._nreads = 0
+
+    @property
+    def readSize(self) -> int:
+        """Total number of bytes read by the batch"""
+        return self._rsize
+
+    def __len__(self):
+        return self._nops
+
+
 cdef class FT4222:
     cdef FT_HANDLE _handle
     cdef DWORD _chip_version
     cdef DWORD _dll_version
+    cdef DWORD _event_mask
+    cdef _OpStats* _stats
+    cdef _OpStats* _statsData
+    cdef _Event _event
+    # set while a CommandQueue owns the handle
+    cdef bint _queued
+    # calls in progress plus running streams and captures, _CLOSING while closing
+    cdef size_t _users
+
+    def __cinit__(self):
+        self._event_mask = 0
+        self._stats = NULL
+        self._statsData = NULL
+        _event_init(&self._event)
+
+    def __dealloc__(self):
+        free(self._statsData)
+        _event_destroy(&self._event)
 
     def __init__(self, handle, update=True):
         self._handle = <FT_HANDLE><uintptr_t>handle
@@ -178,22 +852,56 @@ cdef class FT4222:
 
     def __del__(self):
         if self._handle != NULL:
-            FT4222_UnInitialize(self._handle)
-            FT_Close(self._handle)
+            with nogil:
+                FT4222_UnInitialize(self._handle)
+                FT_Close(self._handle)
 
     def close(self):
-        """Closes the device."""
-        status = FT4222_UnInitialize(self._handle)
-        if status != FT4222_OK:
-            raise FT4222DeviceError, status
-        status = FT_Close(self._handle)
-        if status != FT4222_OK:
-            raise FT4222DeviceError, status
-        self._handle = NULL
+        """Closes the device.
+
+        The handle is shared by all threads. It is not closed while another thread is in
+        a call on it or while a stream or capture is running on it.
+
+        Raises:
+            FT4222DeviceError: on error
+            RuntimeError: if the device is in queued mode or in use
+
+        """
+        cdef FT4222_STATUS status
+        cdef FT_STATUS ftStatus
+        if self._queued:
+            raise RuntimeError("the device is in queued mode, close the queue first")
+        if not _atomic_cas(&self._users, 0, _CLOSING):
+            raise RuntimeError("the device is in use by another thread, a stream or a capture")
+        try:
+            with nogil:
+                status = FT4222_UnInitialize(self._handle)
+            if status != FT4222_OK:
+                raise FT4222DeviceError, status
+            with nogil:
+                ftStatus = FT_Close(self._handle)
+            if ftStatus != FT_OK:
+                raise FT4222DeviceError, ftStatus
+            self._handle = NULL
+            self._event_mask = 0
+        finally:
+            _atomic_add(&self._users, -_CLOSING)
+
+    cdef int _acquire(self) except -1:
+        """Register a user of the handle, which keeps close() from closing it"""
+        if _atomic_add(&self._users, 1) & _CLOSING:
+            self._release()
+            raise RuntimeError("the device is being closed")
+        return 0
+
+    cdef void _release(self) noexcept nogil:
+        _atomic_add(&self._users, <size_t>-1)
 
     cdef _get_version(self):
         cdef FT4222_Version ver
-        status = FT4222_GetVersion(self._handle, &ver)
+        cdef FT4222_STATUS status
+        with nogil:
+            status = FT4222_GetVersion(self._handle, &ver)
         if status == FT4222_OK:
             self._chip_version = ver.chipVersion
             self._dll_version = ver.dllVersion
@@ -219,7 +927,92 @@ cdef class FT4222:
     def __repr__(self):
         return "FT4222: chipVersion: 0x{:x} ({:s}), libVersion: 0x{:x}".format(self._chip_version, self.chipRevision, self._dll_version)
 
-    def setTimeouts(self, read_timeout, write_timeout):
+    def queue(self, int notifyFd=-1, callback=None):
+        """Switch to queued mode.
+
+        A worker thread takes over the handle and executes commands submitted from any
+        thread in order, see :class:`CommandQueue`. The device must not be used directly
+        and can't be closed until the queue is closed.
+
+        Args:
+            notifyFd (int): File descriptor to signal every completion on, -1 for none
+            callback (callable): Called from the worker thread after every command
+
+        Returns:
+            :obj:`CommandQueue`: Command queue of the device
+
+        Raises:
+            RuntimeError: if the device is already in queued mode
+
+        """
+        return CommandQueue(self, notifyFd, callback)
+
+    def enableStats(self, bint enable=True):
+        """Enable or disable the call statistics of this device.
+
+        While enabled, every call into the library for SPI, I2C, GPIO and vendor commands is
+        counted together with the bytes moved and its wall time. When disabled (the default)
+        the overhead is a single pointer check per call. Disabling keeps the collected
+        statistics, use :meth:`resetStats` to clear them.
+
+        Args:
+            enable (bool): True to enable, False to disable the statistics
+
+        """
+        if enable and self._statsData == NULL:
+            self._statsData = <_OpStats*>calloc(_OP_COUNT, sizeof(_OpStats))
+            if self._statsData == NULL:
+                raise MemoryError()
+        self._stats = self._statsData if enable else NULL
+
+    @property
+    def statsEnabled(self) -> bool:
+        """bool: True if the call statistics are enabled"""
+        return self._stats != NULL
+
+    def stats(self):
+        """Get the call statistics collected since enabling them or the last :meth:`resetStats`.
+
+        The result maps the name of each called library function (e.g. ``'SPIMaster_SingleRead'``)
+        to a dict with the following keys:
+
+        - calls: number of calls
+        - errors: number of calls which failed
+        - bytes: bytes moved by the successful calls
+        - total_ns, max_ns, mean_ns: cumulative, maximal and mean wall time in ns
+        - histogram: maps the exclusive upper bound in ns of each populated log2 bucket
+          to the number of calls in that bucket (the lower bound is half of it)
+
+        Returns:
+            dict: Statistics per library function, only functions which were called are listed
+
+        """
+        cdef _OpStats* s
+        cdef int i
+        res = {}
+        if self._statsData == NULL:
+            return res
+        for i in range(<int>_OP_COUNT):
+            s = &self._statsData[i]
+            if s.calls == 0:
+                continue
+            res[_stats_op_names[i]] = {
+                'calls': s.calls,
+                'errors': s.errors,
+                'bytes': s.bytes,
+                'total_ns': s.totalNs,
+                'max_ns': s.maxNs,
+                'mean_ns': s.totalNs // s.calls,
+                'histogram': {2 << b: s.histogram[b] for b in range(STATS_BUCKETS) if s.histogram[b]},
+            }
+        return res
+
+    def resetStats(self):
+        """Clear the call statistics."""
+        if self._statsData != NULL:
+            memset(self._statsData, 0, _OP_COUNT * sizeof(_OpStats))
+
+    def setTimeouts(self, ULONG read_timeout, ULONG write_timeout):
         """Set the read and write timeouts
 
         Args:
@@ -230,11 +1023,129 @@ cdef class FT4222:
             FT2XXDeviceError: on error
 
         """
-        status = FT_SetTimeouts(self._handle, read_timeout, write_timeout)
+        cdef FT_STATUS status
+        self._acquire()
+        with nogil:
+            status = FT_SetTimeouts(self._handle, read_timeout, write_timeout)
+        self._release()
+        if status != FT_OK:
+            raise FT2XXDeviceError, status
+
+    def setLatencyTimer(self, UCHAR latency):
+        """Set the latency timer.
+
+        The chip sends a partially filled USB packet when the timer expires, so it bounds
+        the time a short reply waits in the chip.
+
+        Args:
+            latency (int): Latency in milliseconds (2 to 255)
+
+        Raises:
+            FT2XXDeviceError: on error
+
+        """
+        cdef FT_STATUS status
+        self._acquire()
+        with nogil:
+            status = FT_SetLatencyTimer(self._handle, latency)
+        self._release()
+        if status != FT_OK:
+            raise FT2XXDeviceError, status
+
+    def getLatencyTimer(self):
+        """Get the latency timer.
+
+        Returns:
+            int: Latency in milliseconds
+
+        Raises:
+            FT2XXDeviceError: on error
+
+        """
+        cdef UCHAR latency
+        cdef FT_STATUS status
+        self._acquire()
+        with nogil:
+            status = FT_GetLatencyTimer(self._handle, &latency)
+        self._release()
+        if status == FT_OK:
+            return latency
+        raise FT2XXDeviceError, status
+
+    def setUSBParameters(self, ULONG inTransferSize, ULONG outTransferSize=0):
+        """Set the size of the USB transfer requests.
+
+        Args:
+            inTransferSize (int): Size of the IN requests in bytes, a multiple of 64 up to 65536
+            outTransferSize (int): Size of the OUT requests in bytes, 0 to keep it
+                (not supported by all drivers)
+
+        Raises:
+            FT2XXDeviceError: on error
+
+        """
+        cdef FT_STATUS status
+        self._acquire()
+        with nogil:
+            status = FT_SetUSBParameters(self._handle, inTransferSize, outTransferSize)
+        self._release()
+        if status != FT_OK:
+            raise FT2XXDeviceError, status
+
+    def purge(self, ULONG mask=FT_PURGE_RX | FT_PURGE_TX):
+        """Discard the data in the receive and/or transmit buffers of the driver.
+
+        Args:
+            mask (:obj:`ft4222.Purge`): Buffers to purge
+
+        Raises:
+            FT2XXDeviceError: on error
+
+        """
+        cdef FT_STATUS status
+        self._acquire()
+        with nogil:
+            status = FT_Purge(self._handle, mask)
+        self._release()
         if status != FT_OK:
             raise FT2XXDeviceError, status
 
-    def setClock(self, clk):
+    def tune(self, profile='default', **overrides):
+        """Set the latency timer, the USB transfer sizes and the timeouts together.
+
+        The profiles are defined in :data:`TUNING_PROFILES`: ``'low_latency'`` for many
+        small transactions, ``'bulk'`` for throughput with large transfers and
+        ``'default'`` for the settings the driver starts with (no timeouts)::
+
+            dev.tune('low_latency')
+            dev.tune('bulk', readTimeout=10000)
+
+        Args:
+            profile (str): Name of the profile
+            **overrides: Settings to use instead of the ones of the profile, any of
+                latency, inTransferSize, outTransferSize, readTimeout and writeTimeout
+
+        Returns:
+            dict: Settings applied
+
+        Raises:
+            FT2XXDeviceError: on error
+            ValueError: if the profile or a setting is unknown
+
+        """
+        if profile not in TUNING_PROFILES:
+            raise ValueError("unknown profile {!r}, one of {}".format(profile, ', '.join(TUNING_PROFILES)))
+        settings = dict(TUNING_PROFILES[profile])
+        unknown = set(overrides) - set(settings)
+        if unknown:
+            raise ValueError("unknown settings: {}".format(', '.join(sorted(unknown))))
+        settings.update(overrides)
+        self.setLatencyTimer(settings['latency'])
+        self.setUSBParameters(settings['inTransferSize'], settings['outTransferSize'])
+        self.setTimeouts(settings['readTimeout'], settings['writeTimeout'])
+        return settings
+
+    def setClock(self, FT4222_ClockRate clk):
         """Set the system clock
 
         Args:
@@ -244,7 +1155,11 @@ cdef class FT4222:
             FT4222DeviceError: on error
 
         """
-        status = FT4222_SetClock(self._handle, clk)
+        cdef FT4222_STATUS status
+        self._acquire()
+        with nogil:
+            status = FT4222_SetClock(self._handle, clk)
+        self._release()
         if status != FT4222_OK:
             raise FT4222DeviceError, status
 
@@ -259,12 +1174,16 @@ cdef class FT4222:
 
         """
         cdef FT4222_ClockRate clk
-        status = FT4222_GetClock(self._handle, &clk)
+        cdef FT4222_STATUS status
+        self._acquire()
+        with nogil:
+            status = FT4222_GetClock(self._handle, &clk)
+        self._release()
         if status == FT4222_OK:
             return SysClock(clk)
         raise FT4222DeviceError, status
 
-    def setSuspendOut(self, enable):
+    def setSuspendOut(self, bint enable):
         """Enable or disable, suspend out, which will emit a signal when FT4222H enters suspend mode.
 
         Args:
@@ -274,11 +1193,15 @@ cdef class FT4222:
             FT4222DeviceError: on error
 
         """
-        status = FT4222_SetSuspendOut(self._handle, enable)
+        cdef FT4222_STATUS status
+        self._acquire()
+        with nogil:
+            status = FT4222_SetSuspendOut(self._handle, enable)
+        self._release()
         if status != FT4222_OK:
             raise FT4222DeviceError, status
 
-    def setWakeUpInterrupt(self, enable):
+    def setWakeUpInterrupt(self, bint enable):
         """Enable or disable the wakeup/interrupt
 
         Args:
@@ -288,31 +1211,95 @@ cdef class FT4222:
             FT4222DeviceError: on error
 
         """
-        status = FT4222_SetWakeUpInterrupt(self._handle, enable)
+        cdef FT4222_STATUS status
+        self._acquire()
+        with nogil:
+            status = FT4222_SetWakeUpInterrupt(self._handle, enable)
+        self._release()
         if status != FT4222_OK:
             raise FT4222DeviceError, status
 
+    def waitForEvent(self, DWORD mask=FT4222_EVENT_RXCHAR, timeout=None):
+        """Wait until one of the events in mask occurs, without holding the GIL.
+
+        Instead of busy polling e.g. :meth:`spiSlave_GetRxStatus` a consumer can sleep until new
+        data arrives. The notification is registered with the library on the first call and
+        whenever mask changes. An event which occurs while nobody is waiting is remembered until
+        the next call, so the usual pattern is to drain the receive queue and then wait::
+
+            while True:
+                size = dev.spiSlave_GetRxStatus()
+                if size:
+                    process(dev.spiSlave_Read(size))
+                else:
+                    dev.waitForEvent(ft4222.Event.RXCHAR, timeout=1.0)
+
+        Args:
+            mask (:obj:`ft4222.Event`): Events to wait for
+            timeout (float, None): Maximum time to wait in seconds, None to wait forever
+
+        Returns:
+            bool: True if an event occurred, False on timeout
+
+        Raises:
+            FT4222DeviceError: on error
 
-    def vendorCmdGet(self, req, bytesToRead):
+        """
+        cdef FT4222_STATUS status
+        cdef double ctimeout = -1 if timeout is None else max(timeout, 0)
+        cdef bint signaled
+        cdef void* param
+        if mask == 0:
+            raise ValueError("mask must not be empty")
+        if mask != self._event_mask:
+            param = _event_param(&self._event)
+            if param == NULL:
+                raise FT4222DeviceError, FT4222_INSUFFICIENT_RESOURCES
+            self._acquire()
+            with nogil:
+                status = FT4222_SetEventNotification(self._handle, mask, param)
+            self._release()
+            if status != FT4222_OK:
+                raise FT4222DeviceError, status
+            self._event_mask = mask
+        with nogil:
+            signaled = _event_wait(&self._event, ctimeout)
+        return signaled
+
+    def vendorCmdGet(self, UCHAR req, USHORT bytesToRead):
         """Vendor get command"""
         cdef:
             array[uint8] buf = array('B', [])
+            FT_STATUS status
+            uint64_t t0
         resize(buf, bytesToRead)
-        status = FT_VendorCmdGet(self._handle, req, buf.data.as_uchars, bytesToRead)
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT_VendorCmdGet(self._handle, req, buf.data.as_uchars, bytesToRead)
+            _stats_end(self._stats, _OP_VENDORCMDGET, t0, status, bytesToRead)
+        self._release()
         if status == FT_OK:
             return bytes(buf)
         raise FT4222DeviceError, status
 
-    def vendorCmdSet(self, req, data):
+    def vendorCmdSet(self, UCHAR req, data):
         """Vendor set command"""
-        if isinstance(data, int):
-            data = bytes([data])
-        elif not isinstance(data, (bytes, bytearray)):
-            raise TypeError("the data argument must be of type 'int', 'bytes' or 'bytearray'")
         cdef:
-            uint16 bytesSent
-            uint8* cdata = data
-        status = FT_VendorCmdSet(self._handle, req, cdata, len(data))
+            const uint8[::1] view = _data_view(data, 'data')
+            uint8* cdata = <uint8*>&view[0] if view.shape[0] > 0 else NULL
+            USHORT size
+            FT_STATUS status
+            uint64_t t0
+        if view.shape[0] > 0xFFFF:
+            raise ValueError("data must not be larger than 65535 bytes")
+        size = view.shape[0]
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT_VendorCmdSet(self._handle, req, cdata, size)
+            _stats_end(self._stats, _OP_VENDORCMDSET, t0, status, size)
+        self._release()
         if status != FT_OK:
             raise FT4222DeviceError, status
 
@@ -333,6 +1320,8 @@ cdef class FT4222:
         """
         cdef:
             GPIO_Dir ioDir[4]
+            FT4222_STATUS status
+            uint64_t t0
         if len(args) > 0:
             for i in xrange(len(args)):
                 ioDir[i] = args[i]
@@ -343,11 +1332,16 @@ cdef class FT4222:
             ioDir[1] = gpio1
             ioDir[2] = gpio2
             ioDir[3] = gpio3
-        status = FT4222_GPIO_Init(self._handle, ioDir)
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT4222_GPIO_Init(self._handle, ioDir)
+            _stats_end(self._stats, _OP_GPIO_INIT, t0, status, 0)
+        self._release()
         if status != FT4222_OK:
             raise FT4222DeviceError, status
 
-    def gpio_Read(self, portNum):
+    def gpio_Read(self, GPIO_Port portNum):
         """Read value from selected GPIO
 
         Args:
@@ -362,12 +1356,19 @@ cdef class FT4222:
         """
         cdef:
             BOOL value
-        status = FT4222_GPIO_Read(self._handle, portNum, &value)
+            FT4222_STATUS status
+            uint64_t t0
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT4222_GPIO_Read(self._handle, portNum, &value)
+            _stats_end(self._stats, _OP_GPIO_READ, t0, status, 0)
+        self._release()
         if status == FT4222_OK:
             return value
         raise FT4222DeviceError, status
 
-    def gpio_Write(self, portNum, value):
+    def gpio_Write(self, GPIO_Port portNum, bint value):
         """Write value to given GPIO
 
         Args:
@@ -378,11 +1379,103 @@ cdef class FT4222:
             FT4222DeviceError: on error
 
         """
-        status = FT4222_GPIO_Write(self._handle, portNum, value)
+        cdef FT4222_STATUS status
+        cdef uint64_t t0
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT4222_GPIO_Write(self._handle, portNum, value)
+            _stats_end(self._stats, _OP_GPIO_WRITE, t0, status, 0)
+        self._release()
+        if status != FT4222_OK:
+            raise FT4222DeviceError, status
+
+    def gpio_WriteSequence(self, const uint8[::1] samples, uint8 mask=0xF, uint32 interval=0):
+        """Write a sequence of states to the GPIOs.
+
+        Each byte of samples holds the state of all four GPIOs, bit n is the level of GPIOn.
+        The library has no bulk GPIO output, every pin that changes from one sample to the
+        next is set with its own :meth:`gpio_Write`, i.e. it costs one USB round trip per
+        edge. The sequence saves the Python overhead between the writes only: it runs in
+        one call without the GIL. The first sample writes all pins in mask. The timing is
+        bound by the USB latency, this is not suitable for generating waveforms.
+
+        Example::
+
+            dev.gpio_Init(gpio2=Dir.OUTPUT, gpio3=Dir.OUTPUT)
+            # reset pulse on GPIO3, then 4 strobes on GPIO2
+            dev.gpio_WriteSequence(bytes([0x8, 0x0, 0x8] + [0xC, 0x8] * 4), mask=0xC)
+
+        Args:
+            samples (bytes, bytearray, memoryview): States of the GPIOs, one byte per sample
+            mask (int): GPIOs to drive, bit n selects GPIOn, the pins must be outputs
+            interval (int): Microseconds to wait after each sample
+
+        Returns:
+            int: Number of GPIO writes done
+
+        Raises:
+            FT4222DeviceError: on error
+
+        """
+        cdef:
+            size_t size = samples.shape[0]
+            const uint8* cdata = &samples[0] if size > 0 else NULL
+            size_t i
+            size_t writes = 0
+            uint8 changed
+            uint8 prev = ~cdata[0] if size > 0 else 0
+            int port
+            FT4222_STATUS status = FT4222_OK
+            uint64_t t0
+        self._acquire()
+        with nogil:
+            for i in range(size):
+                changed = (cdata[i] ^ prev) & mask
+                for port in range(4):
+                    if changed & (1 << port):
+                        t0 = _stats_begin(self._stats)
+                        status = FT4222_GPIO_Write(self._handle, <GPIO_Port>port, (cdata[i] >> port) & 1)
+                        _stats_end(self._stats, _OP_GPIO_WRITE, t0, status, 0)
+                        if status != FT4222_OK:
+                            break
+                        writes += 1
+                if status != FT4222_OK:
+                    break
+                prev = cdata[i]
+                if interval > 0:
+                    _sleep_us(interval)
+        self._release()
+        if status != FT4222_OK:
+            raise FT4222DeviceError, status
+        return writes
+
+    def gpio_SetWaveFormMode(self, bint enable):
+        """Enable or disable the WaveForm mode.
+
+        In WaveForm mode the device samples the GPIO inputs periodically and records the
+        levels in the trigger queues instead of the trigger events. The sample rate depends
+        on the system clock.
+
+        Args:
+            enable (bool): True to enable, False to disable
+
+        Raises:
+            FT4222DeviceError: on error
+
+        """
+        cdef FT4222_STATUS status
+        cdef uint64_t t0
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT4222_GPIO_SetWaveFormMode(self._handle, enable)
+            _stats_end(self._stats, _OP_GPIO_SETWAVEFORMMODE, t0, status, 0)
+        self._release()
         if status != FT4222_OK:
             raise FT4222DeviceError, status
 
-    def gpio_SetInputTrigger(self, portNum, trigger):
+    def gpio_SetInputTrigger(self, GPIO_Port portNum, GPIO_Trigger trigger):
         """Set software trigger conditions on the specified GPIO pin.
 
         Args:
@@ -393,11 +1486,18 @@ cdef class FT4222:
             FT4222DeviceError: on error
 
         """
-        status = FT4222_GPIO_SetInputTrigger(self._handle, portNum, trigger)
+        cdef FT4222_STATUS status
+        cdef uint64_t t0
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT4222_GPIO_SetInputTrigger(self._handle, portNum, trigger)
+            _stats_end(self._stats, _OP_GPIO_SETINPUTTRIGGER, t0, status, 0)
+        self._release()
         if status != FT4222_OK:
             raise FT4222DeviceError, status
 
-    def gpio_GetTriggerStatus(self, portNum):
+    def gpio_GetTriggerStatus(self, GPIO_Port portNum):
         """Get the size of trigger event queue.
 
         Args:
@@ -412,7 +1512,14 @@ cdef class FT4222:
         """
         cdef:
             uint16 queueSize
-        status = FT4222_GPIO_GetTriggerStatus(self._handle, portNum, &queueSize)
+            FT4222_STATUS status
+            uint64_t t0
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT4222_GPIO_GetTriggerStatus(self._handle, portNum, &queueSize)
+            _stats_end(self._stats, _OP_GPIO_GETTRIGGERSTATUS, t0, status, 0)
+        self._release()
         if status == FT4222_OK:
             return queueSize
         raise FT4222DeviceError, status
@@ -420,6 +1527,9 @@ cdef class FT4222:
     def gpio_ReadTriggerQueue(self, portNum, readSize=None):
         """Get events recorded in the trigger event queue.
 
+        For high event rates use :meth:`gpio_ReadTriggerQueue_into` or
+        :meth:`gpio_ReadTriggerQueues_into`, which avoid creating an object per event.
+
         Args:
             portNum (:obj:`ft4222.GPIO.Port`): GPIO Port number
             readSize (:obj:`int`, optional): Size of the queue, :obj:`gpio_GetTriggerStatus()` gets called if omitted
@@ -431,21 +1541,145 @@ cdef class FT4222:
             FT4222DeviceError: on error
 
         """
-        if readSize == None:
-            self.gpio_GetTriggerStatus(portNum)
+        if readSize is None:
+            readSize = self.gpio_GetTriggerStatus(portNum)
         cdef:
-            GPIO_Trigger *events = <GPIO_Trigger*>alloca(portNum * sizeof(GPIO_Trigger))
+            GPIO_Port cportNum = portNum
+            uint16 creadSize = readSize
+            GPIO_Trigger *events = <GPIO_Trigger*>malloc(max(creadSize, 1) * sizeof(GPIO_Trigger))
             uint16 sizeRead
-        status = FT4222_GPIO_ReadTriggerQueue(self._handle, portNum, events, readSize, &sizeRead)
+            FT4222_STATUS status
+            uint64_t t0
+        if events == NULL:
+            raise MemoryError()
+        try:
+            self._acquire()
+            with nogil:
+                t0 = _stats_begin(self._stats)
+                status = FT4222_GPIO_ReadTriggerQueue(self._handle, cportNum, events, creadSize, &sizeRead)
+                _stats_end(self._stats, _OP_GPIO_READTRIGGERQUEUE, t0, status, sizeRead)
+            self._release()
+            if status == FT4222_OK:
+                return [Trigger(events[i]) for i in range(sizeRead)]
+        finally:
+            free(events)
+        raise FT4222DeviceError, status
+
+    cdef FT4222_STATUS _gpio_Drain(self, GPIO_Port portNum, uint16* events, size_t size, uint16* sizeRead) noexcept nogil:
+        """Read up to size pending events of a port into events"""
+        cdef:
+            uint16 pending, i
+            GPIO_Trigger* triggers
+            uint64_t t0 = _stats_begin(self._stats)
+            FT4222_STATUS status = FT4222_GPIO_GetTriggerStatus(self._handle, portNum, &pending)
+        _stats_end(self._stats, _OP_GPIO_GETTRIGGERSTATUS, t0, status, 0)
+        sizeRead[0] = 0
+        if status != FT4222_OK or pending == 0 or size == 0:
+            return status
+        if pending > size:
+            pending = <uint16>size
+        # GPIO_Trigger is an enum, its size is up to the compiler
+        triggers = <GPIO_Trigger*>malloc(pending * sizeof(GPIO_Trigger))
+        if triggers == NULL:
+            return FT4222_INSUFFICIENT_RESOURCES
+        t0 = _stats_begin(self._stats)
+        status = FT4222_GPIO_ReadTriggerQueue(self._handle, portNum, triggers, pending, sizeRead)
+        _stats_end(self._stats, _OP_GPIO_READTRIGGERQUEUE, t0, status, sizeRead[0])
         if status == FT4222_OK:
-            res = []
-            for i in xrange(readSize):
-                res.append(Trigger(events[i]))
-            return res
+            for i in range(sizeRead[0]):
+                events[i] = <uint16>triggers[i]
+        else:
+            sizeRead[0] = 0
+        free(triggers)
+        return status
+
+    def gpio_ReadTriggerQueue_into(self, GPIO_Port portNum, uint16[::1] buffer):
+        """Read all pending events of the trigger event queue into a buffer.
+
+        The queue size is requested and the events are read in one call without the GIL.
+        Each event is stored as its :obj:`ft4222.GPIO.Trigger` value.
+
+        Args:
+            portNum (:obj:`ft4222.GPIO.Port`): GPIO Port number
+            buffer (array('H'), memoryview): Writable uint16 buffer, up to len(buffer) events are read
+
+        Returns:
+            int: Number of events read
+
+        Raises:
+            FT4222DeviceError: on error
+
+        """
+        cdef:
+            uint16* cbuf = &buffer[0] if buffer.shape[0] > 0 else NULL
+            size_t size = buffer.shape[0]
+            uint16 sizeRead
+            FT4222_STATUS status
+        self._acquire()
+        with nogil:
+            status = self._gpio_Drain(portNum, cbuf, size, &sizeRead)
+        self._release()
+        if status == FT4222_OK:
+            return sizeRead
         raise FT4222DeviceError, status
 
+    def gpio_ReadTriggerQueues_into(self, uint16[::1] buffer, ports=(0, 1, 2, 3)):
+        """Read the pending events of several ports into one buffer.
+
+        All ports are drained in one call without the GIL. The events of the ports are stored
+        back to back in the given order, the returned counts tell where the events of each port
+        are. If the buffer is full, the remaining events stay in the queues.
+
+        Example::
+
+            buf = array.array('H', bytes(2 * 4096))
+            counts = dev.gpio_ReadTriggerQueues_into(buf, (Port.P0, Port.P1))
+            p0, p1 = buf[:counts[0]], buf[counts[0]:counts[0] + counts[1]]
+
+        Args:
+            buffer (array('H'), memoryview): Writable uint16 buffer
+            ports (:obj:`list` of :obj:`ft4222.GPIO.Port`): Ports to drain (up to 4)
+
+        Returns:
+            :obj:`tuple` of :obj:`int`: Number of events read per port
+
+        Raises:
+            FT4222DeviceError: on error, its ``counts`` attribute holds the number of events
+                read per port before the error, like the return value
+
+        """
+        cdef:
+            GPIO_Port cports[4]
+            uint16 counts[4]
+            size_t nports = len(ports)
+            size_t i
+            size_t offset = 0
+            size_t size = buffer.shape[0]
+            uint16* cbuf = &buffer[0] if buffer.shape[0] > 0 else NULL
+            FT4222_STATUS status = FT4222_OK
+        if nports > 4:
+            raise ValueError("at most 4 ports can be drained")
+        for i in range(nports):
+            cports[i] = ports[i]
+            counts[i] = 0
+        self._acquire()
+        with nogil:
+            for i in range(nports):
+                status = self._gpio_Drain(cports[i], cbuf + offset, size - offset, &counts[i])
+                if status != FT4222_OK:
+                    break
+                offset += counts[i]
+        self._release()
+        res = tuple([counts[i] for i in range(nports)])
+        if status != FT4222_OK:
+            # the events of the ports drained so far are gone from the queues
+            err = FT4222DeviceError(status)
+            err.counts = res
+            raise err
+        return res
+
 
-    def i2cMaster_Init(self, kbps=100):
+    def i2cMaster_Init(self, uint32 kbps=100):
         """Initialize the FT4222H as an I2C master with the requested I2C speed.
 
         Args:
@@ -455,7 +1689,14 @@ cdef class FT4222:
             FT4222DeviceError: on error
 
         """
-        status = FT4222_I2CMaster_Init(self._handle, kbps)
+        cdef FT4222_STATUS status
+        cdef uint64_t t0
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT4222_I2CMaster_Init(self._handle, kbps)
+            _stats_end(self._stats, _OP_I2CMASTER_INIT, t0, status, 0)
+        self._release()
         if status != FT4222_OK:
             raise FT4222DeviceError, status
         # current version (v1.3) of ftdi's lib can only handle clock rates down to 60kHz
@@ -474,7 +1715,7 @@ cdef class FT4222:
             self.setClock(SysClock.CLK_24)
             self.vendorCmdSet(0x52, n)
 
-    def i2cMaster_Read(self, addr, bytesToRead):
+    def i2cMaster_Read(self, uint16 addr, uint16 bytesToRead):
         """Read data from the specified I2C slave device with START and STOP conditions.
 
         Args:
@@ -491,71 +1732,160 @@ cdef class FT4222:
         cdef:
             array[uint8] buf = array('B', [])
             uint16 bytesRead
+            FT4222_STATUS status
+            uint64_t t0
         resize(buf, bytesToRead)
-        status = FT4222_I2CMaster_Read(self._handle, addr, buf.data.as_uchars, bytesToRead, &bytesRead)
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT4222_I2CMaster_Read(self._handle, addr, buf.data.as_uchars, bytesToRead, &bytesRead)
+            _stats_end(self._stats, _OP_I2CMASTER_READ, t0, status, bytesRead)
+        self._release()
         resize(buf, bytesRead)
         if status == FT4222_OK:
             return bytes(buf)
         raise FT4222DeviceError, status
 
-    def i2cMaster_Write(self, addr, data):
-        """Write data to the specified I2C slave device with START and STOP conditions.
+    def i2cMaster_Read_into(self, uint16 addr, uint8[::1] buffer):
+        """Read data from the specified I2C slave device with START and STOP conditions
+        directly into a writable buffer.
 
         Args:
             addr (int): I2C slave address
-            data (int, bytes, bytearray): Data to write to slave
+            buffer (bytearray, memoryview): Writable buffer, len(buffer) bytes are read (max. 65535 bytes)
 
         Returns:
-            int: Bytes sent to slave
+            int: Number of bytes read from slave
 
         Raises:
             FT4222DeviceError: on error
 
         """
-        if isinstance(data, int):
-            data = bytes([data])
-        elif not isinstance(data, (bytes, bytearray)):
-            raise TypeError("the data argument must be of type 'int', 'bytes' or 'bytearray'")
+        if buffer.shape[0] > 0xFFFF:
+            raise ValueError("the buffer must not be larger than 65535 bytes")
         cdef:
-            uint16 bytesSent
-            uint8* cdata = data
-        status = FT4222_I2CMaster_Write(self._handle, addr, cdata, len(data), &bytesSent)
+            uint8* cbuf = &buffer[0] if buffer.shape[0] > 0 else NULL
+            uint16 size = buffer.shape[0]
+            uint16 bytesRead
+            FT4222_STATUS status
+            uint64_t t0
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT4222_I2CMaster_Read(self._handle, addr, cbuf, size, &bytesRead)
+            _stats_end(self._stats, _OP_I2CMASTER_READ, t0, status, bytesRead)
+        self._release()
         if status == FT4222_OK:
-            return bytesSent
+            return bytesRead
         raise FT4222DeviceError, status
 
-    def i2cMaster_ReadEx(self, addr, flag, bytesToRead):
-        """Read data from the specified I2C slave device with the specified I2C condition.
+    def i2cMaster_Write(self, uint16 addr, data):
+        """Write data to the specified I2C slave device with START and STOP conditions.
 
         Args:
             addr (int): I2C slave address
-            flag (:obj:`ft4222.I2CMaster.Flag`): Flag to control start- and stopbit generation
-            bytesToRead (int): Number of bytes to read from slave
+            data (int, bytes-like): Data to write to slave
 
         Returns:
-            bytes: Bytes read from slave
+            int: Bytes sent to slave
 
         Raises:
             FT4222DeviceError: on error
 
         """
         cdef:
-            array[uint8] buf = array('B', [])
-            uint16 bytesRead
+            const uint8[::1] view = _data_view(data, 'data')
+            uint16 bytesSent
+            uint8* cdata = <uint8*>&view[0] if view.shape[0] > 0 else NULL
+            uint16 size
+            FT4222_STATUS status
+            uint64_t t0
+        if view.shape[0] > 0xFFFF:
+            raise ValueError("data must not be larger than 65535 bytes")
+        size = view.shape[0]
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT4222_I2CMaster_Write(self._handle, addr, cdata, size, &bytesSent)
+            _stats_end(self._stats, _OP_I2CMASTER_WRITE, t0, status, bytesSent)
+        self._release()
+        if status == FT4222_OK:
+            return bytesSent
+        raise FT4222DeviceError, status
+
+    def i2cMaster_ReadEx(self, uint16 addr, uint8 flag, uint16 bytesToRead):
+        """Read data from the specified I2C slave device with the specified I2C condition.
+
+        Args:
+            addr (int): I2C slave address
+            flag (:obj:`ft4222.I2CMaster.Flag`): Flag to control start- and stopbit generation
+            bytesToRead (int): Number of bytes to read from slave
+
+        Returns:
+            bytes: Bytes read from slave
+
+        Raises:
+            FT4222DeviceError: on error
+
+        """
+        cdef:
+            array[uint8] buf = array('B', [])
+            uint16 bytesRead
+            FT4222_STATUS status
+            uint64_t t0
         resize(buf, bytesToRead)
-        status = FT4222_I2CMaster_ReadEx(self._handle, addr, flag, buf.data.as_uchars, bytesToRead, &bytesRead)
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT4222_I2CMaster_ReadEx(self._handle, addr, flag, buf.data.as_uchars, bytesToRead, &bytesRead)
+            _stats_end(self._stats, _OP_I2CMASTER_READEX, t0, status, bytesRead)
+        self._release()
         resize(buf, bytesRead)
         if status == FT4222_OK:
             return bytes(buf)
         raise FT4222DeviceError, status
 
-    def i2cMaster_WriteEx(self, addr, flag, data):
+    def i2cMaster_ReadEx_into(self, uint16 addr, uint8 flag, uint8[::1] buffer):
+        """Read data from the specified I2C slave device with the specified I2C condition
+        directly into a writable buffer.
+
+        Args:
+            addr (int): I2C slave address
+            flag (:obj:`ft4222.I2CMaster.Flag`): Flag to control start- and stopbit generation
+            buffer (bytearray, memoryview): Writable buffer, len(buffer) bytes are read (max. 65535 bytes)
+
+        Returns:
+            int: Number of bytes read from slave
+
+        Raises:
+            FT4222DeviceError: on error
+
+        """
+        if buffer.shape[0] > 0xFFFF:
+            raise ValueError("the buffer must not be larger than 65535 bytes")
+        cdef:
+            uint8* cbuf = &buffer[0] if buffer.shape[0] > 0 else NULL
+            uint16 size = buffer.shape[0]
+            uint16 bytesRead
+            FT4222_STATUS status
+            uint64_t t0
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT4222_I2CMaster_ReadEx(self._handle, addr, flag, cbuf, size, &bytesRead)
+            _stats_end(self._stats, _OP_I2CMASTER_READEX, t0, status, bytesRead)
+        self._release()
+        if status == FT4222_OK:
+            return bytesRead
+        raise FT4222DeviceError, status
+
+    def i2cMaster_WriteEx(self, uint16 addr, uint8 flag, data):
         """Write data to the specified I2C slave device with the specified I2C condition.
 
         Args:
             addr (int): I2C slave address
             flag (:obj:`ft4222.I2CMaster.Flag`): Flag to control start- and stopbit generation
-            data (int, bytes, bytearray): Data to write to slave
+            data (int, bytes-like): Data to write to slave
 
         Returns:
             int: Bytes sent to slave
@@ -564,18 +1894,136 @@ cdef class FT4222:
             FT4222DeviceError: on error
 
         """
-        if isinstance(data, int):
-            data = bytes([data])
-        elif not isinstance(data, (bytes, bytearray)):
-            raise TypeError("the data argument must be of type 'int', 'bytes' or 'bytearray'")
         cdef:
+            const uint8[::1] view = _data_view(data, 'data')
             uint16 bytesSent
-            uint8* cdata = data
-        status = FT4222_I2CMaster_WriteEx(self._handle, addr, flag, cdata, len(data), &bytesSent)
+            uint8* cdata = <uint8*>&view[0] if view.shape[0] > 0 else NULL
+            uint16 size
+            FT4222_STATUS status
+            uint64_t t0
+        if view.shape[0] > 0xFFFF:
+            raise ValueError("data must not be larger than 65535 bytes")
+        size = view.shape[0]
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT4222_I2CMaster_WriteEx(self._handle, addr, flag, cdata, size, &bytesSent)
+            _stats_end(self._stats, _OP_I2CMASTER_WRITEEX, t0, status, bytesSent)
+        self._release()
         if status == FT4222_OK:
             return bytesSent
         raise FT4222DeviceError, status
 
+    def i2cMaster_Transfer(self, msgs):
+        """Execute a list of I2C messages as one combined transaction, similar to the
+        ``I2C_RDWR`` ioctl of Linux.
+
+        Each message is a tuple ``(addr, flag, payload)`` or ``(addr, payload)``. A bytes-like
+        payload is written to the slave, an int payload is the number of bytes to read. If
+        flag is None (or omitted), the start- and stopbit generation is derived from the
+        position of the message: the first message starts with START, every further message
+        with REPEATED_START and the last one ends with STOP. Otherwise flag is used as given.
+        The whole list is executed without the GIL. If a message fails while a transaction is
+        open, a STOP is sent to release the bus (or the I2C master is reset if that fails too).
+
+        Example: Read two bytes from register 0x10 of slave 0x50::
+
+            data = dev.i2cMaster_Transfer([(0x50, b'\x10'), (0x50, 2)])
+
+        Args:
+            msgs (:obj:`list` of :obj:`tuple`): Messages to execute
+
+        Returns:
+            bytes: Data of all read messages, concatenated
+
+        Raises:
+            FT4222DeviceError: on error
+
+        """
+        cdef:
+            size_t n = len(msgs)
+            size_t i
+            size_t rsize = 0
+            _I2CMsg* cmsgs = <_I2CMsg*>malloc(n * sizeof(_I2CMsg)) if n > 0 else NULL
+            _I2CMsg* m
+            const uint8[::1] view
+            bytes buf
+            uint8* cbuf
+            uint16 done
+            FT4222_STATUS status = FT4222_OK
+            bint started = False
+            uint64_t t0
+        if n > 0 and cmsgs == NULL:
+            raise MemoryError()
+        # keep the write buffers alive while their data is referenced by the messages
+        views = []
+        try:
+            for i, msg in enumerate(msgs):
+                if len(msg) == 2:
+                    addr, payload = msg
+                    flag = None
+                else:
+                    addr, flag, payload = msg
+                m = &cmsgs[i]
+                m.addr = addr
+                if flag is not None:
+                    m.flag = flag
+                elif n == 1:
+                    m.flag = I2C_MasterFlag.START_AND_STOP
+                elif i == 0:
+                    m.flag = I2C_MasterFlag.START
+                elif i == n - 1:
+                    m.flag = I2C_MasterFlag.Repeated_START | I2C_MasterFlag.STOP
+                else:
+                    m.flag = I2C_MasterFlag.Repeated_START
+                if isinstance(payload, int):
+                    if payload > 0xFFFF:
+                        raise ValueError("messages must not be larger than 65535 bytes")
+                    m.read = True
+                    m.size = payload
+                    m.data = NULL
+                    rsize += m.size
+                else:
+                    view = _data_view(payload, 'payload')
+                    if view.shape[0] > 0xFFFF:
+                        raise ValueError("messages must not be larger than 65535 bytes")
+                    m.read = False
+                    m.size = view.shape[0]
+                    m.data = <uint8*>&view[0] if view.shape[0] > 0 else NULL
+                    views.append(view)
+            buf = PyBytes_FromStringAndSize(NULL, rsize)
+            cbuf = <uint8*>PyBytes_AS_STRING(buf)
+            self._acquire()
+            with nogil:
+                for i in range(n):
+                    m = &cmsgs[i]
+                    if m.flag & I2C_MasterFlag.START:
+                        started = True
+                    t0 = _stats_begin(self._stats)
+                    if m.read:
+                        status = FT4222_I2CMaster_ReadEx(self._handle, m.addr, m.flag, cbuf, m.size, &done)
+                        _stats_end(self._stats, _OP_I2CMASTER_READEX, t0, status, done)
+                        cbuf += m.size
+                    else:
+                        status = FT4222_I2CMaster_WriteEx(self._handle, m.addr, m.flag, m.data, m.size, &done)
+                        _stats_end(self._stats, _OP_I2CMASTER_WRITEEX, t0, status, done)
+                    if status == FT4222_OK and done != m.size:
+                        status = FT4222_FAILED_TO_READ_DEVICE if m.read else FT4222_FAILED_TO_WRITE_DEVICE
+                    if status != FT4222_OK:
+                        break
+                    if m.flag & I2C_MasterFlag.STOP:
+                        started = False
+                if status != FT4222_OK and started:
+                    # don't leave the slave in the middle of the transaction
+                    if FT4222_I2CMaster_WriteEx(self._handle, m.addr, I2C_MasterFlag.STOP, NULL, 0, &done) != FT4222_OK:
+                        FT4222_I2CMaster_Reset(self._handle)
+            self._release()
+        finally:
+            free(cmsgs)
+        if status != FT4222_OK:
+            raise FT4222DeviceError, status
+        return buf
+
     def i2cMaster_Reset(self):
         """Reset the I2C master device.
 
@@ -586,7 +2034,14 @@ cdef class FT4222:
             FT4222DeviceError: on error
 
         """
-        status = FT4222_I2CMaster_Reset(self._handle)
+        cdef FT4222_STATUS status
+        cdef uint64_t t0
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT4222_I2CMaster_Reset(self._handle)
+            _stats_end(self._stats, _OP_I2CMASTER_RESET, t0, status, 0)
+        self._release()
         if status != FT4222_OK:
             raise FT4222DeviceError, status
 
@@ -603,12 +2058,259 @@ cdef class FT4222:
 
         """
         cdef uint8 cs
-        status = FT4222_I2CMaster_GetStatus(self._handle, &cs)
+        cdef FT4222_STATUS status
+        cdef uint64_t t0
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT4222_I2CMaster_GetStatus(self._handle, &cs)
+            _stats_end(self._stats, _OP_I2CMASTER_GETSTATUS, t0, status, 0)
+        self._release()
         if status == FT4222_OK:
             return ControllerStatus(cs)
         raise FT4222DeviceError, status
 
 
+    def i2cSlave_Init(self):
+        """Initialize the FT4222H as an I2C slave.
+
+        Raises:
+            FT4222DeviceError: on error
+
+        """
+        cdef FT4222_STATUS status
+        cdef uint64_t t0
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT4222_I2CSlave_Init(self._handle)
+            _stats_end(self._stats, _OP_I2CSLAVE_INIT, t0, status, 0)
+        self._release()
+        if status != FT4222_OK:
+            raise FT4222DeviceError, status
+
+    def i2cSlave_Reset(self):
+        """Reset the I2C slave device and clear its receive and transmit queues.
+
+        Raises:
+            FT4222DeviceError: on error
+
+        """
+        cdef FT4222_STATUS status
+        cdef uint64_t t0
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT4222_I2CSlave_Reset(self._handle)
+            _stats_end(self._stats, _OP_I2CSLAVE_RESET, t0, status, 0)
+        self._release()
+        if status != FT4222_OK:
+            raise FT4222DeviceError, status
+
+    def i2cSlave_GetAddress(self):
+        """Get the address of the I2C slave device.
+
+        Returns:
+            int: 7bit I2C slave address
+
+        Raises:
+            FT4222DeviceError: on error
+
+        """
+        cdef uint8 addr
+        cdef FT4222_STATUS status
+        cdef uint64_t t0
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT4222_I2CSlave_GetAddress(self._handle, &addr)
+            _stats_end(self._stats, _OP_I2CSLAVE_GETADDRESS, t0, status, 0)
+        self._release()
+        if status == FT4222_OK:
+            return addr
+        raise FT4222DeviceError, status
+
+    def i2cSlave_SetAddress(self, uint8 addr):
+        """Set the address of the I2C slave device. The default address is 0x40.
+
+        Args:
+            addr (int): 7bit I2C slave address
+
+        Raises:
+            FT4222DeviceError: on error
+
+        """
+        cdef FT4222_STATUS status
+        cdef uint64_t t0
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT4222_I2CSlave_SetAddress(self._handle, addr)
+            _stats_end(self._stats, _OP_I2CSLAVE_SETADDRESS, t0, status, 0)
+        self._release()
+        if status != FT4222_OK:
+            raise FT4222DeviceError, status
+
+    def i2cSlave_GetRxStatus(self):
+        """Get number of bytes in the receive queue.
+
+        Returns:
+            int: Number of bytes in the receive queue
+
+        Raises:
+            FT4222DeviceError: on error
+
+        """
+        cdef uint16 rxSize
+        cdef FT4222_STATUS status
+        cdef uint64_t t0
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT4222_I2CSlave_GetRxStatus(self._handle, &rxSize)
+            _stats_end(self._stats, _OP_I2CSLAVE_GETRXSTATUS, t0, status, 0)
+        self._release()
+        if status == FT4222_OK:
+            return rxSize
+        raise FT4222DeviceError, status
+
+    def i2cSlave_Read(self, uint16 bytesToRead):
+        """Read data from the receive queue of the I2C slave device.
+
+        Args:
+            bytesToRead (int): Number of bytes to read
+
+        Returns:
+            bytes: Bytes read from the receive queue
+
+        Raises:
+            FT4222DeviceError: on error
+
+        """
+        cdef:
+            bytes buf = PyBytes_FromStringAndSize(NULL, bytesToRead)
+            uint8* cbuf = <uint8*>PyBytes_AS_STRING(buf)
+            uint16 sizeRead
+            FT4222_STATUS status
+            uint64_t t0
+
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT4222_I2CSlave_Read(self._handle, cbuf, bytesToRead, &sizeRead)
+            _stats_end(self._stats, _OP_I2CSLAVE_READ, t0, status, sizeRead)
+        self._release()
+        if status != FT4222_OK:
+            raise FT4222DeviceError, status
+        return buf if sizeRead == bytesToRead else buf[:sizeRead]
+
+    def i2cSlave_Read_into(self, uint8[::1] buffer):
+        """Read data from the receive queue of the I2C slave device directly into a writable buffer.
+
+        Args:
+            buffer (bytearray, memoryview): Writable buffer, up to len(buffer) bytes are read (max. 65535 bytes)
+
+        Returns:
+            int: Number of bytes read
+
+        Raises:
+            FT4222DeviceError: on error
+
+        """
+        cdef:
+            uint8* cbuf = &buffer[0] if buffer.shape[0] > 0 else NULL
+            uint16 size = min(buffer.shape[0], 0xFFFF)
+            uint16 sizeRead
+            FT4222_STATUS status
+            uint64_t t0
+
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT4222_I2CSlave_Read(self._handle, cbuf, size, &sizeRead)
+            _stats_end(self._stats, _OP_I2CSLAVE_READ, t0, status, sizeRead)
+        self._release()
+        if status == FT4222_OK:
+            return sizeRead
+        raise FT4222DeviceError, status
+
+    def i2cSlave_Write(self, data):
+        """Write data to the transmit queue of the I2C slave device.
+
+        Args:
+            data (bytes-like, int): Data to write
+
+        Returns:
+            int: Number of bytes written to the device
+
+        Raises:
+            FT4222DeviceError: on error
+
+        """
+        cdef:
+            const uint8[::1] view = _data_view(data, 'data')
+            uint8* cdata = <uint8*>&view[0] if view.shape[0] > 0 else NULL
+            uint16 size
+            uint16 sizeTransferred
+            FT4222_STATUS status
+            uint64_t t0
+        if view.shape[0] > 0xFFFF:
+            raise ValueError("data must not be larger than 65535 bytes")
+        size = view.shape[0]
+
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT4222_I2CSlave_Write(self._handle, cdata, size, &sizeTransferred)
+            _stats_end(self._stats, _OP_I2CSLAVE_WRITE, t0, status, sizeTransferred)
+        self._release()
+        if status == FT4222_OK:
+            return sizeTransferred
+        raise FT4222DeviceError, status
+
+    def i2cSlave_SetClockStretch(self, bint enable):
+        """Enable or disable clock stretching of the I2C slave device. Default is disabled.
+
+        Args:
+            enable (bool): True to enable, False to disable clock stretching
+
+        Raises:
+            FT4222DeviceError: on error
+
+        """
+        cdef FT4222_STATUS status
+        cdef uint64_t t0
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT4222_I2CSlave_SetClockStretch(self._handle, enable)
+            _stats_end(self._stats, _OP_I2CSLAVE_SETCLOCKSTRETCH, t0, status, 0)
+        self._release()
+        if status != FT4222_OK:
+            raise FT4222DeviceError, status
+
+    def i2cSlave_SetRespWord(self, uint8 responseWord):
+        """Set the response word which is sent to the master if the transmit queue is empty
+        and clock stretching is disabled. Default is 0xFF.
+
+        Args:
+            responseWord (int): Response word
+
+        Raises:
+            FT4222DeviceError: on error
+
+        """
+        cdef FT4222_STATUS status
+        cdef uint64_t t0
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT4222_I2CSlave_SetRespWord(self._handle, responseWord)
+            _stats_end(self._stats, _OP_I2CSLAVE_SETRESPWORD, t0, status, 0)
+        self._release()
+        if status != FT4222_OK:
+            raise FT4222DeviceError, status
+
     def spi_Reset(self):
         """Reset the SPI master or slave device
 
@@ -616,11 +2318,18 @@ cdef class FT4222:
             FT4222DeviceError: on error
 
         """
-        status = FT4222_SPI_Reset(self._handle);
+        cdef FT4222_STATUS status
+        cdef uint64_t t0
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT4222_SPI_Reset(self._handle)
+            _stats_end(self._stats, _OP_SPI_RESET, t0, status, 0)
+        self._release()
         if status != FT4222_OK:
             raise FT4222DeviceError, status
 
-    def spi_ResetTransaction(self, spiIdx):
+    def spi_ResetTransaction(self, uint8 spiIdx):
         """Reset the SPI transaction
 
         Args:
@@ -630,11 +2339,18 @@ cdef class FT4222:
             FT4222DeviceError: on error
 
         """
-        status = FT4222_SPI_ResetTransaction(self._handle, spiIdx);
+        cdef FT4222_STATUS status
+        cdef uint64_t t0
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT4222_SPI_ResetTransaction(self._handle, spiIdx)
+            _stats_end(self._stats, _OP_SPI_RESETTRANSACTION, t0, status, 0)
+        self._release()
         if status != FT4222_OK:
             raise FT4222DeviceError, status
 
-    def spi_SetDrivingStrength(self, clkStrength, ioStrength, ssoStrength):
+    def spi_SetDrivingStrength(self, SPI_DrivingStrength clkStrength, SPI_DrivingStrength ioStrength, SPI_DrivingStrength ssoStrength):
         """Reset the SPI master or slave device.
 
         Args:
@@ -646,11 +2362,18 @@ cdef class FT4222:
             FT4222DeviceError: on error
 
         """
-        status = FT4222_SPI_SetDrivingStrength(self._handle, clkStrength, ioStrength, ssoStrength);
+        cdef FT4222_STATUS status
+        cdef uint64_t t0
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT4222_SPI_SetDrivingStrength(self._handle, clkStrength, ioStrength, ssoStrength)
+            _stats_end(self._stats, _OP_SPI_SETDRIVINGSTRENGTH, t0, status, 0)
+        self._release()
         if status != FT4222_OK:
             raise FT4222DeviceError, status
 
-    def spiMaster_Init(self, mode, clock, cpol, cpha, ssoMap):
+    def spiMaster_Init(self, FT4222_SPIMode mode, FT4222_SPIClock clock, FT4222_SPICPOL cpol, FT4222_SPICPHA cpha, uint8 ssoMap):
         """Initialize as an SPI master under all modes.
 
         Args:
@@ -664,11 +2387,18 @@ cdef class FT4222:
             FT4222DeviceError: on error
 
         """
-        status = FT4222_SPIMaster_Init(self._handle, mode, clock, cpol, cpha, ssoMap);
+        cdef FT4222_STATUS status
+        cdef uint64_t t0
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT4222_SPIMaster_Init(self._handle, mode, clock, cpol, cpha, ssoMap)
+            _stats_end(self._stats, _OP_SPIMASTER_INIT, t0, status, 0)
+        self._release()
         if status != FT4222_OK:
             raise FT4222DeviceError, status
 
-    def spiMaster_SetLines(self, mode):
+    def spiMaster_SetLines(self, FT4222_SPIMode mode):
         """Switch the FT4222H SPI master to single, dual, or quad mode.
 
         This overrides the mode passed to FT4222_SPIMaster_init. This might be needed if a
@@ -681,13 +2411,69 @@ cdef class FT4222:
             FT4222DeviceError: on error
 
         """
-        status = FT4222_SPIMaster_SetLines(self._handle, mode);
+        cdef FT4222_STATUS status
+        cdef uint64_t t0
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT4222_SPIMaster_SetLines(self._handle, mode)
+            _stats_end(self._stats, _OP_SPIMASTER_SETLINES, t0, status, 0)
+        self._release()
         if status != FT4222_OK:
             raise FT4222DeviceError, status
 
-    def spiMaster_SingleRead(self, bytesToRead, isEndTransaction):
+    cdef FT4222_STATUS _spiMaster_Single(self, uint8* readBuffer, uint8* writeBuffer, size_t size,
+                                         size_t* sizeTransferred, bint isEndTransaction) noexcept nogil:
+        """Single mode transfer of arbitrary size.
+
+        Transfers larger than 65535 bytes are split into chunks which are a multiple of the
+        maximum transfer size of the chip. The slave select stays asserted between the chunks,
+        isEndTransaction only applies to the last one. readBuffer or writeBuffer may be NULL
+        for a write or a read only transfer.
+        """
+        cdef:
+            FT4222_STATUS status
+            uint16 maxSize
+            uint16 chunk = 0xFFFF
+            uint16 n, done
+            size_t offset = 0
+            bint last
+            _StatsOp op
+            uint64_t t0
+        sizeTransferred[0] = 0
+        if size > 0xFFFF:
+            status = FT4222_GetMaxTransferSize(self._handle, &maxSize)
+            if status != FT4222_OK:
+                return status
+            if maxSize > 0:
+                chunk = (0xFFFF // maxSize) * maxSize
+        while True:
+            n = chunk if size - offset > chunk else <uint16>(size - offset)
+            last = offset + n == size
+            t0 = _stats_begin(self._stats)
+            if readBuffer == NULL:
+                op = _OP_SPIMASTER_SINGLEWRITE
+                status = FT4222_SPIMaster_SingleWrite(self._handle, writeBuffer + offset, n, &done, isEndTransaction and last)
+            elif writeBuffer == NULL:
+                op = _OP_SPIMASTER_SINGLEREAD
+                status = FT4222_SPIMaster_SingleRead(self._handle, readBuffer + offset, n, &done, isEndTransaction and last)
+            else:
+                op = _OP_SPIMASTER_SINGLEREADWRITE
+                status = FT4222_SPIMaster_SingleReadWrite(self._handle, readBuffer + offset, writeBuffer + offset, n, &done, isEndTransaction and last)
+            _stats_end(self._stats, op, t0, status, done)
+            if status != FT4222_OK:
+                return status
+            offset += done
+            sizeTransferred[0] = offset
+            if last or done < n:
+                return FT4222_OK
+
+    def spiMaster_SingleRead(self, size_t bytesToRead, bint isEndTransaction):
         """Read data from a SPI slave in single mode
 
+        Reads larger than 65535 bytes are split into several transfers, the slave select
+        pin stays asserted between them.
+
         Args:
             bytesToRead (int): Number of bytes to read
             isEndTransaction (bool): If True the slave select pin will be raised at the end
@@ -700,20 +2486,56 @@ cdef class FT4222:
 
         """
         cdef:
-            array[uint8] buf = array('B', [])
-            uint16 bytesRead
-        resize(buf, bytesToRead)
-        status = FT4222_SPIMaster_SingleRead(self._handle, buf.data.as_uchars, bytesToRead, &bytesRead, isEndTransaction)
+            bytes buf = PyBytes_FromStringAndSize(NULL, bytesToRead)
+            uint8* cbuf = <uint8*>PyBytes_AS_STRING(buf)
+            size_t bytesRead
+            FT4222_STATUS status
+        self._acquire()
+        with nogil:
+            status = self._spiMaster_Single(cbuf, NULL, bytesToRead, &bytesRead, isEndTransaction)
+        self._release()
         if status == FT4222_OK:
-            resize(buf, bytesRead)
-            return bytes(buf)
+            return buf if bytesRead == bytesToRead else buf[:bytesRead]
+        raise FT4222DeviceError, status
+
+    def spiMaster_SingleRead_into(self, uint8[::1] buffer, bint isEndTransaction):
+        """Read data from a SPI slave in single mode directly into a writable buffer
+
+        Reads larger than 65535 bytes are split into several transfers, the slave select
+        pin stays asserted between them.
+
+        Args:
+            buffer (bytearray, memoryview): Writable buffer, len(buffer) bytes are read
+            isEndTransaction (bool): If True the slave select pin will be raised at the end
+
+        Returns:
+            int: Number of bytes read from slave
+
+        Raises:
+            FT4222DeviceError: on error
+
+        """
+        cdef:
+            uint8* cbuf = &buffer[0] if buffer.shape[0] > 0 else NULL
+            size_t size = buffer.shape[0]
+            size_t bytesRead
+            FT4222_STATUS status
+        self._acquire()
+        with nogil:
+            status = self._spiMaster_Single(cbuf, NULL, size, &bytesRead, isEndTransaction)
+        self._release()
+        if status == FT4222_OK:
+            return bytesRead
         raise FT4222DeviceError, status
 
-    def spiMaster_SingleWrite(self, data, isEndTransaction):
+    def spiMaster_SingleWrite(self, data, bint isEndTransaction):
         """Write data to a SPI slave in single mode
 
+        Writes larger than 65535 bytes are split into several transfers, the slave select
+        pin stays asserted between them.
+
         Args:
-            data (bytes, bytearray, int): Data to write to slave
+            data (bytes-like, int): Data to write to slave
             isEndTransaction (bool): If True the slave select pin will be raised at the end
 
         Returns:
@@ -723,23 +2545,28 @@ cdef class FT4222:
             FT4222DeviceError: on error
 
         """
-        if isinstance(data, int):
-            data = bytes([data])
-        elif not isinstance(data, (bytes, bytearray)):
-            raise TypeError("the data argument must be of type 'int', 'bytes' or 'bytearray'")
         cdef:
-            uint16 bytesSent
-            uint8* cdata = data
-        status = FT4222_SPIMaster_SingleWrite(self._handle, cdata, len(data), &bytesSent, isEndTransaction);
+            const uint8[::1] view = _data_view(data, 'data')
+            size_t bytesSent
+            uint8* cdata = <uint8*>&view[0] if view.shape[0] > 0 else NULL
+            size_t size = view.shape[0]
+            FT4222_STATUS status
+        self._acquire()
+        with nogil:
+            status = self._spiMaster_Single(NULL, cdata, size, &bytesSent, isEndTransaction)
+        self._release()
         if status == FT4222_OK:
             return bytesSent
         raise FT4222DeviceError, status
 
-    def spiMaster_SingleReadWrite(self, data, isEndTransaction):
+    def spiMaster_SingleReadWrite(self, data, bint isEndTransaction):
         """Write and read data to and from a SPI slave in single mode
 
+        Transfers larger than 65535 bytes are split into several transfers, the slave
+        select pin stays asserted between them.
+
         Args:
-            data (bytes, bytearray, int): Data to write to slave
+            data (bytes-like, int): Data to write to slave
             isEndTransaction (bool): If True the slave select pin will be raised at the end
 
         Returns:
@@ -749,27 +2576,64 @@ cdef class FT4222:
             FT4222DeviceError: on error
 
         """
-        if isinstance(data, int):
-            data = bytes([data])
-        elif not isinstance(data, (bytes, bytearray)):
-            raise TypeError("the data argument must be of type 'int', 'bytes' or 'bytearray'")
         cdef:
-            uint16 sizeTransferred
-            uint8* cdata = data
-            array[uint8] buf = array('B', [])
-        resize(buf, len(data))
-        status = FT4222_SPIMaster_SingleReadWrite(self._handle, buf.data.as_uchars, cdata, len(data), &sizeTransferred, isEndTransaction);
+            const uint8[::1] view = _data_view(data, 'data')
+            size_t sizeTransferred
+            size_t size = view.shape[0]
+            uint8* cdata = <uint8*>&view[0] if size > 0 else NULL
+            bytes buf = PyBytes_FromStringAndSize(NULL, size)
+            uint8* cbuf = <uint8*>PyBytes_AS_STRING(buf)
+            FT4222_STATUS status
+        self._acquire()
+        with nogil:
+            status = self._spiMaster_Single(cbuf, cdata, size, &sizeTransferred, isEndTransaction)
+        self._release()
         if status == FT4222_OK:
-            resize(buf, sizeTransferred)
-            return bytes(buf)
+            return buf if sizeTransferred == size else buf[:sizeTransferred]
+        raise FT4222DeviceError, status
+
+    def spiMaster_SingleReadWrite_into(self, uint8[::1] buffer, data, bint isEndTransaction):
+        """Write and read data to and from a SPI slave in single mode, the read data is
+        stored directly in a writable buffer
+
+        Transfers larger than 65535 bytes are split into several transfers, the slave
+        select pin stays asserted between them.
+
+        Args:
+            buffer (bytearray, memoryview): Writable buffer, must hold at least len(data) bytes
+            data (bytes-like, int): Data to write to slave
+            isEndTransaction (bool): If True the slave select pin will be raised at the end
+
+        Returns:
+            int: Number of bytes transferred
+
+        Raises:
+            FT4222DeviceError: on error
+
+        """
+        cdef const uint8[::1] view = _data_view(data, 'data')
+        if buffer.shape[0] < view.shape[0]:
+            raise ValueError("the buffer must be at least as large as data")
+        cdef:
+            size_t sizeTransferred
+            uint8* cdata = <uint8*>&view[0] if view.shape[0] > 0 else NULL
+            size_t size = view.shape[0]
+            uint8* cbuf = &buffer[0] if buffer.shape[0] > 0 else NULL
+            FT4222_STATUS status
+        self._acquire()
+        with nogil:
+            status = self._spiMaster_Single(cbuf, cdata, size, &sizeTransferred, isEndTransaction)
+        self._release()
+        if status == FT4222_OK:
+            return sizeTransferred
         raise FT4222DeviceError, status
 
-    def spiMaster_MultiReadWrite(self, singleWrite, multiWrite, bytesToRead):
+    def spiMaster_MultiReadWrite(self, singleWrite, multiWrite, uint16 bytesToRead):
         """Write and read data to and from a SPI slave in dual- or quad-mode (multi-mode).
 
         Args:
-            singleWrite (bytes, bytearray, int): Data to write to slave in signle-line mode (max. 15 bytes)
-            multiWrite (bytes, bytearray, int): Data to write to slave in multi-line mode (max. 65535 bytes)
+            singleWrite (bytes-like, int): Data to write to slave in signle-line mode (max. 15 bytes)
+            multiWrite (bytes-like, int): Data to write to slave in multi-line mode (max. 65535 bytes)
             bytesToRead (int):  Number of bytes to read on multi-line (max. 65535 bytes)
 
         Returns:
@@ -779,26 +2643,89 @@ cdef class FT4222:
             FT4222DeviceError: on error
 
         """
-        if isinstance(singleWrite, int):
-            data = bytes([singleWrite])
-        elif not isinstance(singleWrite, (bytes, bytearray)):
-            raise TypeError("the singleWrite argument must be of type 'int', 'bytes' or 'bytearray'")
-        if isinstance(multiWrite, int):
-            data = bytes([multiWrite])
-        elif not isinstance(multiWrite, (bytes, bytearray)):
-            raise TypeError("the multiWrite argument must be of type 'int', 'bytes' or 'bytearray'")
-        write = singleWrite + multiWrite
         cdef:
-            uint8* cdata = write
+            const uint8[::1] single = _data_view(singleWrite, 'singleWrite')
+            const uint8[::1] multi = _data_view(multiWrite, 'multiWrite')
+        if single.shape[0] > 15:
+            raise ValueError("singleWrite must not be larger than 15 bytes")
+        if multi.shape[0] > 0xFFFF:
+            raise ValueError("multiWrite must not be larger than 65535 bytes")
+        cdef:
+            uint8 singleSize = single.shape[0]
+            uint16 multiSize = multi.shape[0]
+            uint8* cdata = <uint8*>malloc(singleSize + multiSize + 1)
             array[uint8] buf = array('B', [])
             uint32 bytesRead
-        resize(buf, bytesToRead)
-        status = FT4222_SPIMaster_MultiReadWrite(self._handle, buf.data.as_uchars, cdata, len(singleWrite), len(multiWrite), bytesToRead, &bytesRead);
+            FT4222_STATUS status
+            uint64_t t0
+        if cdata == NULL:
+            raise MemoryError()
+        try:
+            resize(buf, bytesToRead)
+            _concat(cdata, single, multi)
+            self._acquire()
+            with nogil:
+                t0 = _stats_begin(self._stats)
+                status = FT4222_SPIMaster_MultiReadWrite(self._handle, buf.data.as_uchars, cdata, singleSize, multiSize, bytesToRead, &bytesRead)
+                _stats_end(self._stats, _OP_SPIMASTER_MULTIREADWRITE, t0, status, bytesRead + singleSize + multiSize)
+            self._release()
+        finally:
+            free(cdata)
         if status == FT4222_OK:
             resize(buf, bytesRead)
             return bytes(buf)
         raise FT4222DeviceError, status
 
+    def spiMaster_MultiReadWrite_into(self, uint8[::1] buffer, singleWrite, multiWrite):
+        """Write and read data to and from a SPI slave in dual- or quad-mode (multi-mode),
+        the read data is stored directly in a writable buffer.
+
+        Args:
+            buffer (bytearray, memoryview): Writable buffer, len(buffer) bytes are read on multi-line (max. 65535 bytes)
+            singleWrite (bytes-like, int): Data to write to slave in signle-line mode (max. 15 bytes)
+            multiWrite (bytes-like, int): Data to write to slave in multi-line mode (max. 65535 bytes)
+
+        Returns:
+            int: Number of bytes read from slave in multi-line mode
+
+        Raises:
+            FT4222DeviceError: on error
+
+        """
+        cdef:
+            const uint8[::1] single = _data_view(singleWrite, 'singleWrite')
+            const uint8[::1] multi = _data_view(multiWrite, 'multiWrite')
+        if buffer.shape[0] > 0xFFFF:
+            raise ValueError("the buffer must not be larger than 65535 bytes")
+        if single.shape[0] > 15:
+            raise ValueError("singleWrite must not be larger than 15 bytes")
+        if multi.shape[0] > 0xFFFF:
+            raise ValueError("multiWrite must not be larger than 65535 bytes")
+        cdef:
+            uint8 singleSize = single.shape[0]
+            uint16 multiSize = multi.shape[0]
+            uint8* cdata = <uint8*>malloc(singleSize + multiSize + 1)
+            uint8* cbuf = &buffer[0] if buffer.shape[0] > 0 else NULL
+            uint16 size = buffer.shape[0]
+            uint32 bytesRead
+            FT4222_STATUS status
+            uint64_t t0
+        if cdata == NULL:
+            raise MemoryError()
+        try:
+            _concat(cdata, single, multi)
+            self._acquire()
+            with nogil:
+                t0 = _stats_begin(self._stats)
+                status = FT4222_SPIMaster_MultiReadWrite(self._handle, cbuf, cdata, singleSize, multiSize, size, &bytesRead)
+                _stats_end(self._stats, _OP_SPIMASTER_MULTIREADWRITE, t0, status, bytesRead + singleSize + multiSize)
+            self._release()
+        finally:
+            free(cdata)
+        if status == FT4222_OK:
+            return bytesRead
+        raise FT4222DeviceError, status
+
     def spiMaster_EndTransaction(self):
         """End the current SPI transaction.
 
@@ -807,12 +2734,84 @@ cdef class FT4222:
 
         """
         cdef:
-            DWORD bytesSent;
-        status = FT_Write(self._handle, <unsigned char*>NULL, 0, &bytesSent);
+            DWORD bytesSent
+            FT_STATUS status
+            uint64_t t0
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT_Write(self._handle, <unsigned char*>NULL, 0, &bytesSent)
+            _stats_end(self._stats, _OP_SPIMASTER_ENDTRANSACTION, t0, status, 0)
+        self._release()
         if status == FT_OK:
             return
         raise FT4222DeviceError, status
 
+    def spiMaster_Batch(self, SPIBatch batch):
+        """Execute a pre-compiled sequence of SPI master operations in single mode.
+
+        The whole sequence runs in one loop without the GIL. The data of all reads is
+        returned in one contiguous buffer, the data of the n-th read is
+        ``data[offsets[n]:offsets[n + 1]]``.
+
+        Args:
+            batch (:obj:`ft4222.SPIBatch`): Operations to execute
+
+        Returns:
+            tuple: (bytes, list of int): Data of all reads and the offsets of the single reads within it
+
+        Raises:
+            FT4222DeviceError: on error
+
+        """
+        cdef:
+            bytes buf = PyBytes_FromStringAndSize(NULL, batch._rsize)
+            uint8* cbuf = <uint8*>PyBytes_AS_STRING(buf)
+            size_t i
+            FT4222_STATUS status
+        # the buffers of the batch must not be reallocated while the loop runs
+        batch._executing += 1
+        try:
+            self._acquire()
+            with nogil:
+                status = self._spiMaster_RunBatch(batch, cbuf)
+            self._release()
+        finally:
+            batch._executing -= 1
+        if status != FT4222_OK:
+            raise FT4222DeviceError, status
+        offsets = [batch._ops[i].readOffset for i in range(batch._nops)
+                   if batch._ops[i].kind == _SPI_BATCH_READ or batch._ops[i].kind == _SPI_BATCH_READWRITE]
+        offsets.append(batch._rsize)
+        return buf, offsets
+
+    cdef FT4222_STATUS _spiMaster_RunBatch(self, SPIBatch batch, uint8* cbuf) noexcept nogil:
+        """Run the operations of batch, reads go to cbuf"""
+        cdef:
+            _SPIBatchOp* op
+            size_t i, done
+            DWORD bytesSent
+            FT4222_STATUS status = FT4222_OK
+            uint64_t t0
+        for i in range(batch._nops):
+            op = &batch._ops[i]
+            if op.kind == _SPI_BATCH_WRITE:
+                status = self._spiMaster_Single(NULL, batch._wdata + op.writeOffset, op.size, &done, op.isEndTransaction)
+            elif op.kind == _SPI_BATCH_READ:
+                status = self._spiMaster_Single(cbuf + op.readOffset, NULL, op.size, &done, op.isEndTransaction)
+            elif op.kind == _SPI_BATCH_READWRITE:
+                status = self._spiMaster_Single(cbuf + op.readOffset, batch._wdata + op.writeOffset, op.size, &done, op.isEndTransaction)
+            else:
+                t0 = _stats_begin(self._stats)
+                status = <FT4222_STATUS>FT_Write(self._handle, <unsigned char*>NULL, 0, &bytesSent)
+                _stats_end(self._stats, _OP_SPIMASTER_ENDTRANSACTION, t0, status, 0)
+                done = op.size
+            if status == FT4222_OK and done != op.size:
+                status = FT4222_FAILED_TO_WRITE_DEVICE if op.kind == _SPI_BATCH_WRITE else FT4222_FAILED_TO_READ_DEVICE
+            if status != FT4222_OK:
+                break
+        return status
+
     def spiSlave_Init(self):
         """Initialize the FT4222H as an SPI slave. Default SPI_SlaveProtocol is SPI_SLAVE_WITH_PROTOCOL.
 
@@ -820,11 +2819,18 @@ cdef class FT4222:
             FT4222DeviceError: on error
 
         """
-        status = FT4222_SPISlave_Init(self._handle);
+        cdef FT4222_STATUS status
+        cdef uint64_t t0
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT4222_SPISlave_Init(self._handle)
+            _stats_end(self._stats, _OP_SPISLAVE_INIT, t0, status, 0)
+        self._release()
         if status != FT4222_OK:
             raise FT4222DeviceError, status
 
-    def spiSlave_InitEx(self, mode):
+    def spiSlave_InitEx(self, SPI_SlaveProtocol mode):
         """Initialize as an SPI slave under all modes.
 
         Args:
@@ -834,11 +2840,18 @@ cdef class FT4222:
             FT4222DeviceError: on error
 
         """
-        status = FT4222_SPISlave_InitEx(self._handle,mode);
+        cdef FT4222_STATUS status
+        cdef uint64_t t0
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT4222_SPISlave_InitEx(self._handle, mode)
+            _stats_end(self._stats, _OP_SPISLAVE_INITEX, t0, status, 0)
+        self._release()
         if status != FT4222_OK:
             raise FT4222DeviceError, status
 
-    def spiSlave_Read(self, bytesToRead):
+    def spiSlave_Read(self, uint16 bytesToRead):
         """Read data from the receive queue of the SPI slave device.
 
         Args:
@@ -854,29 +2867,73 @@ cdef class FT4222:
         cdef:
             array[uint8] buf = array('B', [])
             uint16 sizeRead
+            FT4222_STATUS status
+            uint64_t t0
         resize(buf, bytesToRead)
 
-        status = FT4222_SPISlave_Read(self._handle, buf.data.as_uchars, bytesToRead, &sizeRead);
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT4222_SPISlave_Read(self._handle, buf.data.as_uchars, bytesToRead, &sizeRead)
+            _stats_end(self._stats, _OP_SPISLAVE_READ, t0, status, sizeRead)
+        self._release()
         if status == FT4222_OK:
             resize(buf, sizeRead)
             return bytes(buf)
         raise FT4222DeviceError, status
 
-    def spiSlave_SetMode(self, cpol, cpha):
-        """Set SPI slave cpol and cpha. The Default value of cpol is (:obj:`ft4222.SPI.Cpol.CLK_IDLE_LOW`) , default value of cpha is (:obj:`ft4222.SPI.Cpol.CLK_LEADING`)
+    def spiSlave_Read_into(self, uint8[::1] buffer):
+        """Read data from the receive queue of the SPI slave device directly into a writable buffer.
 
         Args:
-            cpol (:obj:`ft4222.SPI.Cpol`): Clock polarity
-            cpha (:obj:`ft4222.SPI.Cpha`): Clock phase
+            buffer (bytearray, memoryview): Writable buffer, up to len(buffer) bytes are read (max. 65535 bytes)
+
+        Returns:
+            int: Number of bytes read
 
         Raises:
             FT4222DeviceError: on error
 
         """
-        status = FT4222_SPISlave_SetMode(self._handle, cpol, cpha);
-        if status != FT4222_OK:
-            raise FT4222DeviceError, status
-
+        cdef:
+            uint8* cbuf = &buffer[0] if buffer.shape[0] > 0 else NULL
+            uint16 size = min(buffer.shape[0], 0xFFFF)
+            uint16 sizeRead
+            FT4222_STATUS status
+            uint64_t t0
+
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT4222_SPISlave_Read(self._handle, cbuf, size, &sizeRead)
+            _stats_end(self._stats, _OP_SPISLAVE_READ, t0, status, sizeRead)
+        self._release()
+        if status == FT4222_OK:
+            return sizeRead
+        raise FT4222DeviceError, status
+
+    def spiSlave_SetMode(self, FT4222_SPICPOL cpol, FT4222_SPICPHA cpha):
+        """Set SPI slave cpol and cpha. The Default value of cpol is (:obj:`ft4222.SPI.Cpol.CLK_IDLE_LOW`) , default value of cpha is (:obj:`ft4222.SPI.Cpol.CLK_LEADING`)
+
+        Args:
+            cpol (:obj:`ft4222.SPI.Cpol`): Clock polarity
+            cpha (:obj:`ft4222.SPI.Cpha`): Clock phase
+
+        Raises:
+            FT4222DeviceError: on error
+
+        """
+        cdef FT4222_STATUS status
+        cdef uint64_t t0
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT4222_SPISlave_SetMode(self._handle, cpol, cpha)
+            _stats_end(self._stats, _OP_SPISLAVE_SETMODE, t0, status, 0)
+        self._release()
+        if status != FT4222_OK:
+            raise FT4222DeviceError, status
+
     def spiSlave_GetRxStatus(self):
         """Get number of bytes in the receive queue.
 
@@ -889,8 +2946,15 @@ cdef class FT4222:
         """
         cdef:
             uint16 pRxSize
+            FT4222_STATUS status
+            uint64_t t0
 
-        status = FT4222_SPISlave_GetRxStatus(self._handle, &pRxSize);
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT4222_SPISlave_GetRxStatus(self._handle, &pRxSize)
+            _stats_end(self._stats, _OP_SPISLAVE_GETRXSTATUS, t0, status, 0)
+        self._release()
 
         if status == FT4222_OK:
             return pRxSize
@@ -900,7 +2964,7 @@ cdef class FT4222:
         """Write data to the transmit queue of the SPI slave device.
 
         Args:
-            data (bytes, bytearray, int): Data to write to slave
+            data (bytes-like, int): Data to write to slave
 
         Returns:
             sizeTransferred (uint16): Number of bytes written to the device.
@@ -909,15 +2973,2300 @@ cdef class FT4222:
             FT4222DeviceError: on error
 
         """
-        if isinstance(data, int):
-            data = bytes([data])
-        elif not isinstance(data, (bytes, bytearray)):
-            raise TypeError("the data argument must be of type 'int', 'bytes' or 'bytearray'")
         cdef:
+            const uint8[::1] view = _data_view(data, 'data')
             uint16 sizeTransferred
-            uint8* cdata = data
-
-        status = FT4222_SPISlave_Write(self._handle, cdata, len(data), &sizeTransferred);
+            uint8* cdata = <uint8*>&view[0] if view.shape[0] > 0 else NULL
+            uint16 size
+            FT4222_STATUS status
+            uint64_t t0
+        if view.shape[0] > 0xFFFF:
+            raise ValueError("data must not be larger than 65535 bytes")
+        size = view.shape[0]
+        self._acquire()
+        with nogil:
+            t0 = _stats_begin(self._stats)
+            status = FT4222_SPISlave_Write(self._handle, cdata, size, &sizeTransferred)
+            _stats_end(self._stats, _OP_SPISLAVE_WRITE, t0, status, sizeTransferred)
+        self._release()
         if status == FT4222_OK:
             return sizeTransferred
         raise FT4222DeviceError, status
+
+
+cdef extern from *:
+    """
+    /* acquire/release accessors for the indices shared between the producer and consumer of _Ring */
+    #if defined(_MSC_VER)
+    #include <intrin.h>
+    static __inline size_t ft4222_atomic_load(size_t* p) { size_t v = *(volatile size_t*)p; _ReadWriteBarrier(); return v; }
+    static __inline void ft4222_atomic_store(size_t* p, size_t v) { _ReadWriteBarrier(); *(volatile size_t*)p = v; }
+    static __inline void ft4222_atomic_store_u64(uint64_t* p, uint64_t v) { _ReadWriteBarrier(); *(volatile uint64_t*)p = v; }
+    #else
+    #define ft4222_atomic_load(p) __atomic_load_n((p), __ATOMIC_ACQUIRE)
+    #define ft4222_atomic_store(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+    #define ft4222_atomic_store_u64(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+    #endif
+    """
+    size_t _atomic_load "ft4222_atomic_load" (size_t* p) noexcept nogil
+    void _atomic_store "ft4222_atomic_store" (size_t* p, size_t v) noexcept nogil
+    void _atomic_store_u64 "ft4222_atomic_store_u64" (uint64_t* p, uint64_t v) noexcept nogil
+
+
+cdef struct _Ring:
+    # single-producer/single-consumer byte ring, head and tail are free running
+    uint8* data
+    size_t mask
+    size_t head
+    size_t tail
+
+cdef int _ring_init(_Ring* ring, size_t capacity) except -1:
+    cdef size_t size = 1
+    while size < capacity:
+        size <<= 1
+    ring.data = <uint8*>malloc(size)
+    if ring.data == NULL:
+        raise MemoryError()
+    ring.mask = size - 1
+    ring.head = 0
+    ring.tail = 0
+    return 0
+
+cdef inline size_t _ring_used(_Ring* ring) noexcept nogil:
+    return _atomic_load(&ring.head) - _atomic_load(&ring.tail)
+
+cdef inline uint8* _ring_reserve(_Ring* ring, size_t* size) noexcept nogil:
+    """Producer: get the contiguous free space at the write position."""
+    cdef size_t head = ring.head
+    cdef size_t free = ring.mask + 1 - (head - _atomic_load(&ring.tail))
+    cdef size_t offset = head & ring.mask
+    size[0] = min(free, ring.mask + 1 - offset)
+    return ring.data + offset
+
+cdef inline void _ring_commit(_Ring* ring, size_t size) noexcept nogil:
+    """Producer: publish size bytes written to the reserved space."""
+    _atomic_store(&ring.head, ring.head + size)
+
+cdef size_t _ring_read(_Ring* ring, uint8* dest, size_t size) noexcept nogil:
+    """Consumer: copy up to size bytes out of the ring."""
+    cdef size_t tail = ring.tail
+    cdef size_t offset = tail & ring.mask
+    cdef size_t n = min(size, _atomic_load(&ring.head) - tail)
+    cdef size_t first = min(n, ring.mask + 1 - offset)
+    memcpy(dest, ring.data + offset, first)
+    memcpy(dest + first, ring.data, n - first)
+    _atomic_store(&ring.tail, tail + n)
+    return n
+
+
+cdef class _Poller:
+    """Base of the background readers.
+
+    A background thread polls the device without holding the GIL and stores what it
+    receives in a preallocated buffer, which the reader waits on.
+    """
+    cdef FT4222 _dev
+    cdef uint32 _pollInterval
+    cdef size_t _running
+    cdef size_t _overruns
+    cdef FT4222_STATUS _status
+    cdef object _thread
+
+    def __cinit__(self, FT4222 dev, *args, **kwargs):
+        self._dev = dev
+
+    def __dealloc__(self):
+        # the thread keeps the object alive, it is only stopped here if it was never joined
+        if self._thread is not None and self._dev is not None:
+            self._dev._release()
+
+    cdef void _loop(self) noexcept nogil:
+        pass
+
+    cdef size_t _used(self) noexcept nogil:
+        """Units (bytes or records) ready to be read"""
+        return 0
+
+    cdef size_t _limit(self) noexcept nogil:
+        """Most units which can be ready at once"""
+        return 0
+
+    cdef _prepare(self):
+        """Called by start() before the thread is started"""
+        pass
+
+    def _run(self):
+        with nogil:
+            self._loop()
+
+    def start(self):
+        """Start the background thread."""
+        if self._thread is not None and self._thread.is_alive():
+            return
+        self._prepare()
+        if self._thread is None:
+            # the device can't be closed until stop()
+            self._dev._acquire()
+        self._status = FT4222_OK
+        self._running = 1
+        self._thread = threading.Thread(target=self._run, name=type(self).__name__, daemon=True)
+        self._thread.start()
+
+    def stop(self):
+        """Stop the background thread. Data already received stays readable."""
+        if self._thread is None:
+            return
+        _atomic_store(&self._running, 0)
+        self._thread.join()
+        self._thread = None
+        self._dev._release()
+
+    def __enter__(self):
+        self.start()
+        return self
+
+    def __exit__(self, *exc):
+        self.stop()
+
+    @property
+    def running(self) -> bool:
+        """bool: True while the background thread is running"""
+        return _atomic_load(&self._running) != 0
+
+    cdef size_t _wait(self, size_t size, double timeout) except? 0:
+        cdef double deadline = time.monotonic() + timeout
+        cdef size_t used
+        # more than the buffer can hold never becomes available
+        with nogil:
+            size = min(size, self._limit())
+            used = self._used()
+        while used < size and _atomic_load(&self._running):
+            if timeout >= 0 and time.monotonic() >= deadline:
+                break
+            with nogil:
+                _sleep_us(self._pollInterval)
+                used = self._used()
+        if used == 0 and self._status != FT4222_OK:
+            status = self._status
+            self._status = FT4222_OK
+            raise FT4222DeviceError, status
+        return used
+
+
+cdef class _RxStream(_Poller):
+    """Base of the buffered receive streams.
+
+    A background thread polls the receive queue of the device without holding the GIL and
+    drains it into a preallocated ring buffer. Data which does not fit into the ring is
+    dropped and counted as overrun.
+    """
+    cdef _Ring _ring
+    cdef uint8* _scratch
+
+    def __cinit__(self, FT4222 dev, size_t bufferSize=65536, uint32 pollInterval=100):
+        self._pollInterval = pollInterval
+        self._scratch = <uint8*>malloc(0xFFFF)
+        if self._scratch == NULL:
+            raise MemoryError()
+        _ring_init(&self._ring, max(bufferSize, <size_t>256))
+
+    def __dealloc__(self):
+        free(self._ring.data)
+        free(self._scratch)
+
+    cdef FT4222_STATUS _poll(self, uint8* buffer, uint16 size, uint16* sizeRead) noexcept nogil:
+        sizeRead[0] = 0
+        return FT4222_OK
+
+    cdef void _loop(self) noexcept nogil:
+        cdef:
+            uint8* dest
+            size_t free
+            uint16 sizeRead
+            FT4222_STATUS status
+        while _atomic_load(&self._running):
+            dest = _ring_reserve(&self._ring, &free)
+            if free == 0:
+                # ring full: keep the device queue from overflowing, drop the data
+                status = self._poll(self._scratch, 0xFFFF, &sizeRead)
+                _atomic_store(&self._overruns, self._overruns + sizeRead)
+            else:
+                status = self._poll(dest, min(free, <size_t>0xFFFF), &sizeRead)
+                _ring_commit(&self._ring, sizeRead)
+            if status != FT4222_OK:
+                self._status = status
+                _atomic_store(&self._running, 0)
+                break
+            if sizeRead == 0:
+                _sleep_us(self._pollInterval)
+
+    cdef size_t _used(self) noexcept nogil:
+        return _ring_used(&self._ring)
+
+    cdef size_t _limit(self) noexcept nogil:
+        return self._ring.mask + 1
+
+    @property
+    def overruns(self) -> int:
+        """int: Number of bytes dropped because the ring buffer was full"""
+        return _atomic_load(&self._overruns)
+
+    @property
+    def available(self) -> int:
+        """int: Number of bytes in the ring buffer"""
+        return _ring_used(&self._ring)
+
+    def read(self, size_t size, timeout=0):
+        """Read data from the ring buffer.
+
+        Args:
+            size (int): Maximum number of bytes to read
+            timeout (float, None): Seconds to wait until size bytes, or as many as the
+                ring buffer holds, are available, None to wait forever, 0 to return immediately
+
+        Returns:
+            bytes: Data read, may be shorter than size
+
+        Raises:
+            FT4222DeviceError: if the background thread stopped due to an error and
+                the ring buffer is drained
+
+        """
+        cdef size_t n = min(size, self._wait(size, -1 if timeout is None else timeout))
+        cdef bytes buf = PyBytes_FromStringAndSize(NULL, n)
+        _ring_read(&self._ring, <uint8*>PyBytes_AS_STRING(buf), n)
+        return buf
+
+    def readinto(self, uint8[::1] buffer, timeout=0):
+        """Read data from the ring buffer into a writable buffer.
+
+        Args:
+            buffer (bytearray, memoryview): Writable buffer, up to len(buffer) bytes are read
+            timeout (float, None): Seconds to wait until the buffer can be filled, or the
+                ring buffer is full, None to wait forever, 0 to return immediately
+
+        Returns:
+            int: Number of bytes read
+
+        Raises:
+            FT4222DeviceError: if the background thread stopped due to an error and
+                the ring buffer is drained
+
+        """
+        cdef size_t size = buffer.shape[0]
+        cdef size_t n = min(size, self._wait(size, -1 if timeout is None else timeout))
+        if n > 0:
+            _ring_read(&self._ring, &buffer[0], n)
+        return n
+
+
+cdef class I2CSlaveStream(_RxStream):
+    """Buffered receiver for the I2C slave interface.
+
+    A background thread drains the small receive queue of the FT4222H into a ring buffer,
+    so bursts from the bus master don't overflow the chip while Python is busy. The device
+    must already be initialized with :meth:`FT4222.i2cSlave_Init`. Don't call
+    :meth:`FT4222.i2cSlave_Read` while the stream is running, the device can't be closed
+    until it is stopped.
+
+    Example::
+
+        dev.i2cSlave_Init()
+        with ft4222.I2CSlaveStream(dev, bufferSize=1 << 20) as stream:
+            data = stream.read(128, timeout=1.0)
+
+    Args:
+        dev (:obj:`FT4222`): Device initialized as I2C slave
+        bufferSize (int): Size of the ring buffer in bytes (rounded up to a power of two)
+        pollInterval (int): Microseconds to sleep while the receive queue is empty
+
+    """
+
+    cdef FT4222_STATUS _poll(self, uint8* buffer, uint16 size, uint16* sizeRead) noexcept nogil:
+        cdef uint16 rxSize
+        cdef uint64_t t0 = _stats_begin(self._dev._stats)
+        cdef FT4222_STATUS status = FT4222_I2CSlave_GetRxStatus(self._dev._handle, &rxSize)
+        _stats_end(self._dev._stats, _OP_I2CSLAVE_GETRXSTATUS, t0, status, 0)
+        sizeRead[0] = 0
+        if status != FT4222_OK or rxSize == 0:
+            return status
+        t0 = _stats_begin(self._dev._stats)
+        status = FT4222_I2CSlave_Read(self._dev._handle, buffer, min(rxSize, size), sizeRead)
+        _stats_end(self._dev._stats, _OP_I2CSLAVE_READ, t0, status, sizeRead[0])
+        return status
+
+
+cdef class SPISlaveStream(_RxStream):
+    """Buffered receiver for the SPI slave interface.
+
+    A background thread continuously drains the receive queue of the FT4222H into a
+    lock-free ring buffer, so the sustained throughput does not depend on how fast Python
+    consumes the data. The device must already be initialized with
+    :meth:`FT4222.spiSlave_Init` or :meth:`FT4222.spiSlave_InitEx`. Don't call
+    :meth:`FT4222.spiSlave_Read` while the stream is running, the device can't be closed
+    until it is stopped.
+
+    Example::
+
+        dev.spiSlave_InitEx(ft4222.SPISlave.Protocol.SPI_SLAVE_NO_PROTOCOL)
+        with ft4222.SPISlaveStream(dev, bufferSize=16 << 20) as stream:
+            while True:
+                data = stream.read(4096, timeout=1.0)
+                ...
+            print("dropped", stream.overruns)
+
+    Args:
+        dev (:obj:`FT4222`): Device initialized as SPI slave
+        bufferSize (int): Size of the ring buffer in bytes (rounded up to a power of two)
+        pollInterval (int): Microseconds to sleep while the receive queue is empty
+
+    """
+
+    cdef FT4222_STATUS _poll(self, uint8* buffer, uint16 size, uint16* sizeRead) noexcept nogil:
+        cdef uint16 rxSize
+        cdef uint64_t t0 = _stats_begin(self._dev._stats)
+        cdef FT4222_STATUS status = FT4222_SPISlave_GetRxStatus(self._dev._handle, &rxSize)
+        _stats_end(self._dev._stats, _OP_SPISLAVE_GETRXSTATUS, t0, status, 0)
+        sizeRead[0] = 0
+        if status != FT4222_OK or rxSize == 0:
+            return status
+        t0 = _stats_begin(self._dev._stats)
+        status = FT4222_SPISlave_Read(self._dev._handle, buffer, min(rxSize, size), sizeRead)
+        _stats_end(self._dev._stats, _OP_SPISLAVE_READ, t0, status, sizeRead[0])
+        return status
+
+
+cdef struct _GpioRecord:
+    uint64_t t_ns
+    uint16 port
+    uint16 trigger
+    uint32 reserved
+
+DEF GPIO_CAPTURE_BATCH = 1024
+DEF GPIO_CAPTURE_HEADER = 64
+
+
+cdef class GpioCapture(_Poller):
+    """Timestamped capture of GPIO edges.
+
+    A background thread polls the trigger queues of the given ports without holding the
+    GIL. Each drained batch gets the host time (:func:`time.monotonic_ns` on Linux,
+    :func:`time.perf_counter_ns` on Windows) at which its queue status was received, this
+    is an upper bound for the time of the edges. The events are stored as records of
+    ``(port, trigger, t_ns)``. Records which don't fit are dropped and counted as overrun.
+
+    Without file the records go into a ring buffer in memory. With file they are appended
+    to a memory-mapped file of fixed size, which keeps the whole log and can be read by
+    other processes while the capture is running. The file starts with a header of 64 bytes
+    (:attr:`HEADER_FORMAT`: magic ``b'FT4222GC'``, version, record size, capacity in records
+    and the number of records written, updated after every batch), followed by the records
+    (:attr:`RECORD_FORMAT`: t_ns, port, trigger, 4 reserved bytes, native byte order).
+
+    The GPIOs must already be configured as inputs with :meth:`FT4222.gpio_Init`. Don't
+    read the trigger queues while the capture is running, the device can't be closed until
+    it is stopped.
+
+    Example::
+
+        dev.gpio_Init(gpio0=Dir.INPUT, gpio1=Dir.INPUT)
+        with ft4222.GpioCapture(dev, ports=(Port.P0, Port.P1), file='irq.log') as capture:
+            while True:
+                for port, trigger, t_ns in capture.read(timeout=1.0):
+                    ...
+
+    Args:
+        dev (:obj:`FT4222`): Device with GPIOs configured as inputs
+        ports (:obj:`list` of :obj:`ft4222.GPIO.Port`): Ports to capture (up to 4)
+        trigger (:obj:`ft4222.GPIO.Trigger`): Trigger set on the ports when starting,
+            None to keep the triggers as they are
+        bufferSize (int): Capacity in records, rounded up to a power of two without file
+        pollInterval (int): Microseconds to sleep while the trigger queues are empty
+        file (str): Path of the file to log to, None to capture into memory
+
+    """
+
+    RECORD_FORMAT = '=QHH4x'
+    HEADER_FORMAT = '<8sIIQQ32x'
+
+    cdef GPIO_Port _ports[4]
+    cdef size_t _numPorts
+    cdef object _trigger
+    cdef GPIO_Trigger _scratch[GPIO_CAPTURE_BATCH]
+    # memory: ring of records
+    cdef _Ring _ring
+    # file: records after the header, count is published in the header
+    cdef _GpioRecord* _log
+    cdef uint64_t* _logCount
+    cdef size_t _capacity
+    cdef size_t _count
+    cdef size_t _tail
+    cdef object _file
+    cdef object _mmap
+    cdef uint8[::1] _view
+
+    def __cinit__(self, FT4222 dev, ports=(0, 1, 2, 3), trigger=Trigger.RISING | Trigger.FALLING,
+                  size_t bufferSize=65536, uint32 pollInterval=100, file=None):
+        cdef size_t i
+        self._numPorts = len(ports)
+        if self._numPorts == 0 or self._numPorts > 4:
+            raise ValueError("1 to 4 ports can be captured")
+        for i in range(self._numPorts):
+            self._ports[i] = ports[i]
+        self._trigger = trigger
+        self._pollInterval = pollInterval
+        bufferSize = max(bufferSize, <size_t>16)
+        if file is None:
+            _ring_init(&self._ring, bufferSize * sizeof(_GpioRecord))
+            return
+        self._capacity = bufferSize
+        self._file = open(file, 'w+b')
+        try:
+            self._file.truncate(GPIO_CAPTURE_HEADER + bufferSize * sizeof(_GpioRecord))
+            self._mmap = mmap.mmap(self._file.fileno(), 0)
+        except:
+            self._file.close()
+            raise
+        struct.pack_into(self.HEADER_FORMAT, self._mmap, 0, b'FT4222GC', 1, sizeof(_GpioRecord), bufferSize, 0)
+        self._view = self._mmap
+        self._logCount = <uint64_t*>&self._view[24]
+        self._log = <_GpioRecord*>&self._view[GPIO_CAPTURE_HEADER]
+
+    def __dealloc__(self):
+        free(self._ring.data)
+
+    cdef _GpioRecord* _reserve(self, size_t* size) noexcept nogil:
+        cdef uint8* dest
+        if self._log != NULL:
+            size[0] = self._capacity - self._count
+            return self._log + self._count
+        dest = _ring_reserve(&self._ring, size)
+        size[0] //= sizeof(_GpioRecord)
+        return <_GpioRecord*>dest
+
+    cdef void _commit(self, size_t size) noexcept nogil:
+        if self._log != NULL:
+            _atomic_store(&self._count, self._count + size)
+            _atomic_store_u64(self._logCount, self._count)
+        else:
+            _ring_commit(&self._ring, size * sizeof(_GpioRecord))
+
+    cdef void _store(self, GPIO_Port port, uint16 size, uint64_t t_ns) noexcept nogil:
+        cdef:
+            _GpioRecord* rec
+            size_t free, n, i
+            size_t done = 0
+        while done < size:
+            rec = self._reserve(&free)
+            if free == 0:
+                _atomic_store(&self._overruns, self._overruns + size - done)
+                return
+            n = min(free, <size_t>(size - done))
+            for i in range(n):
+                rec[i].t_ns = t_ns
+                rec[i].port = port
+                rec[i].trigger = <uint16>self._scratch[done + i]
+                rec[i].reserved = 0
+            self._commit(n)
+            done += n
+
+    cdef void _loop(self) noexcept nogil:
+        cdef:
+            FT_HANDLE handle = self._dev._handle
+            _OpStats* stats = self._dev._stats
+            FT4222_STATUS status = FT4222_OK
+            uint16 pending, sizeRead
+            uint64_t t0, t_ns
+            size_t i
+            bint idle
+        while _atomic_load(&self._running):
+            idle = True
+            for i in range(self._numPorts):
+                t0 = _stats_begin(stats)
+                status = FT4222_GPIO_GetTriggerStatus(handle, self._ports[i], &pending)
+                _stats_end(stats, _OP_GPIO_GETTRIGGERSTATUS, t0, status, 0)
+                if status != FT4222_OK:
+                    break
+                if pending == 0:
+                    continue
+                t_ns = _monotonic_ns()
+                idle = False
+                t0 = _stats_begin(stats)
+                status = FT4222_GPIO_ReadTriggerQueue(handle, self._ports[i], self._scratch,
+                                                      min(pending, <uint16>GPIO_CAPTURE_BATCH), &sizeRead)
+                _stats_end(stats, _OP_GPIO_READTRIGGERQUEUE, t0, status, sizeRead)
+                if status != FT4222_OK:
+                    break
+                self._store(self._ports[i], sizeRead, t_ns)
+            if status != FT4222_OK:
+                self._status = status
+                _atomic_store(&self._running, 0)
+                break
+            if idle:
+                _sleep_us(self._pollInterval)
+
+    cdef _prepare(self):
+        cdef size_t i
+        if self._trigger is not None:
+            for i in range(self._numPorts):
+                self._dev.gpio_SetInputTrigger(self._ports[i], self._trigger)
+
+    def start(self):
+        """Set the triggers and start the background thread.
+
+        Raises:
+            FT4222DeviceError: on error
+
+        """
+        _Poller.start(self)
+
+    def close(self):
+        """Stop the background thread and close the file."""
+        self.stop()
+        if self._file is None:
+            return
+        self._log = NULL
+        self._logCount = NULL
+        self._view = None
+        self._mmap.flush()
+        self._mmap.close()
+        self._file.close()
+        self._mmap = None
+        self._file = None
+
+    def __exit__(self, *exc):
+        self.close()
+
+    @property
+    def overruns(self) -> int:
+        """int: Number of events dropped because the buffer or file was full"""
+        return _atomic_load(&self._overruns)
+
+    @property
+    def available(self) -> int:
+        """int: Number of records not read yet"""
+        return self._used()
+
+    cdef size_t _used(self) noexcept nogil:
+        if self._log != NULL:
+            return _atomic_load(&self._count) - self._tail
+        return _ring_used(&self._ring) // sizeof(_GpioRecord)
+
+    cdef size_t _limit(self) noexcept nogil:
+        if self._log != NULL:
+            # the file is not reused, at most its unread and free records can be ready
+            return self._capacity - self._tail
+        return (self._ring.mask + 1) // sizeof(_GpioRecord)
+
+    cdef size_t _take(self, _GpioRecord* dest, size_t size) noexcept nogil:
+        if self._log == NULL:
+            return _ring_read(&self._ring, <uint8*>dest, size * sizeof(_GpioRecord)) // sizeof(_GpioRecord)
+        size = min(size, _atomic_load(&self._count) - self._tail)
+        memcpy(dest, self._log + self._tail, size * sizeof(_GpioRecord))
+        self._tail += size
+        return size
+
+    def read(self, size=None, timeout=0):
+        """Read captured records.
+
+        Args:
+            size (int): Maximum number of records to read, None for all available
+            timeout (float, None): Seconds to wait until size records (or any record if size
+                is None) are available, None to wait forever, 0 to return immediately
+
+        Returns:
+            :obj:`list` of :obj:`tuple`: Records as (port, :obj:`ft4222.GPIO.Trigger`, t_ns)
+
+        Raises:
+            FT4222DeviceError: if the background thread stopped due to an error and
+                all records are read
+
+        """
+        cdef size_t n = self._wait(1 if size is None else size, -1 if timeout is None else timeout)
+        cdef size_t i
+        if size is not None:
+            n = min(n, <size_t>size)
+        cdef _GpioRecord* recs = <_GpioRecord*>malloc(max(n, <size_t>1) * sizeof(_GpioRecord))
+        if recs == NULL:
+            raise MemoryError()
+        try:
+            n = self._take(recs, n)
+            return [(recs[i].port, Trigger(recs[i].trigger), recs[i].t_ns) for i in range(n)]
+        finally:
+            free(recs)
+
+    def readinto(self, uint8[::1] buffer, timeout=0):
+        """Read captured records into a writable buffer.
+
+        The records are copied as they are stored, see :attr:`RECORD_FORMAT`.
+
+        Args:
+            buffer (bytearray, memoryview): Writable buffer, up to len(buffer) // 16 records are read
+            timeout (float, None): Seconds to wait until the buffer can be filled,
+                None to wait forever, 0 to return immediately
+
+        Returns:
+            int: Number of records read
+
+        Raises:
+            FT4222DeviceError: if the background thread stopped due to an error and
+                all records are read
+
+        """
+        cdef size_t size = buffer.shape[0] // sizeof(_GpioRecord)
+        cdef size_t n = min(size, self._wait(size, -1 if timeout is None else timeout))
+        if n > 0:
+            n = self._take(<_GpioRecord*>&buffer[0], n)
+        return n
+
+
+DEF FLASH_TIMEOUT = -1
+DEF FLASH_CHUNK = 0xFFFF
+
+cdef class _SPIFlash:
+    """Native part of :class:`ft4222.flash.SPIFlash`.
+
+    Runs whole program, erase, read and verify operations without the GIL, the device must
+    be initialized as SPI master with the flash on the selected slave select. The opcodes
+    and geometry are set with :meth:`_configure`.
+    """
+    cdef FT4222 _dev
+    cdef int _lines
+    cdef uint8 _addrBytes
+    cdef uint32 _pageSize
+    cdef uint8 _readCmd
+    cdef uint8 _readDummy
+    cdef FT4222_SPIMode _readLines
+    cdef uint8 _programCmd
+    cdef uint32 _pollInterval
+
+    def __cinit__(self, FT4222 dev, *args, **kwargs):
+        self._dev = dev
+        self._lines = SPI_IO_NONE
+        self._addrBytes = 3
+        self._pageSize = 256
+        self._readCmd = 0x03
+        self._readDummy = 0
+        self._readLines = SPI_IO_SINGLE
+        self._programCmd = 0x02
+        self._pollInterval = 0
+
+    def _configure(self, uint8 addrBytes, uint32 pageSize, uint8 readCmd, uint8 readDummy,
+                   FT4222_SPIMode readLines, uint8 programCmd, uint32 pollInterval):
+        if addrBytes not in (3, 4) or pageSize == 0 or readDummy > 10:
+            raise ValueError("invalid flash configuration")
+        self._addrBytes = addrBytes
+        self._pageSize = pageSize
+        self._readCmd = readCmd
+        self._readDummy = readDummy
+        self._readLines = readLines
+        self._programCmd = programCmd
+        self._pollInterval = pollInterval
+        # the library might have been switched behind our back
+        self._lines = SPI_IO_NONE
+
+    cdef int _setLines(self, FT4222_SPIMode lines) noexcept nogil:
+        cdef FT4222_STATUS status
+        cdef uint64_t t0
+        if self._lines == <int>lines:
+            return FT4222_OK
+        t0 = _stats_begin(self._dev._stats)
+        status = FT4222_SPIMaster_SetLines(self._dev._handle, lines)
+        _stats_end(self._dev._stats, _OP_SPIMASTER_SETLINES, t0, status, 0)
+        self._lines = lines if status == FT4222_OK else SPI_IO_NONE
+        return status
+
+    cdef int _single(self, uint8* readBuffer, const uint8* writeBuffer, size_t size, bint end) noexcept nogil:
+        cdef size_t done
+        cdef int status = self._setLines(SPI_IO_SINGLE)
+        if status != FT4222_OK:
+            return status
+        status = self._dev._spiMaster_Single(readBuffer, <uint8*>writeBuffer, size, &done, end)
+        if status == FT4222_OK and done != size:
+            return FT4222_FAILED_TO_READ_DEVICE if readBuffer != NULL else FT4222_FAILED_TO_WRITE_DEVICE
+        return status
+
+    cdef size_t _header(self, uint8* buf, uint8 cmd, uint32 addr) noexcept nogil:
+        cdef size_t i
+        buf[0] = cmd
+        for i in range(self._addrBytes):
+            buf[1 + i] = (addr >> (8 * (self._addrBytes - 1 - i))) & 0xFF
+        return 1 + self._addrBytes
+
+    cdef int _waitReady(self, uint64_t timeoutNs) noexcept nogil:
+        cdef:
+            uint8 tx[2]
+            uint8 rx[2]
+            uint64_t deadline = _monotonic_ns() + timeoutNs
+            int status
+        tx[0] = 0x05
+        tx[1] = 0xFF
+        while True:
+            status = self._single(rx, tx, 2, True)
+            if status != FT4222_OK:
+                return status
+            if not (rx[1] & 0x01):
+                return FT4222_OK
+            if _monotonic_ns() > deadline:
+                return FLASH_TIMEOUT
+            if self._pollInterval > 0:
+                _sleep_us(self._pollInterval)
+
+    cdef int _writeEnable(self) noexcept nogil:
+        cdef uint8 cmd = 0x06
+        return self._single(NULL, &cmd, 1, True)
+
+    cdef int _read(self, uint32 addr, uint8* buffer, size_t size) noexcept nogil:
+        cdef:
+            uint8 header[16]
+            size_t n, offset = 0
+            size_t headerSize
+            uint32 sizeRead
+            int status
+            uint64_t t0
+        if self._readLines == SPI_IO_SINGLE:
+            headerSize = self._header(header, self._readCmd, addr)
+            memset(header + headerSize, 0xFF, self._readDummy)
+            status = self._single(NULL, header, headerSize + self._readDummy, False)
+            if status != FT4222_OK:
+                return status
+            return self._single(buffer, NULL, size, True)
+        status = self._setLines(self._readLines)
+        if status != FT4222_OK:
+            return status
+        while offset < size:
+            n = min(size - offset, <size_t>FLASH_CHUNK)
+            headerSize = self._header(header, self._readCmd, addr + <uint32>offset)
+            memset(header + headerSize, 0xFF, self._readDummy)
+            t0 = _stats_begin(self._dev._stats)
+            status = FT4222_SPIMaster_MultiReadWrite(self._dev._handle, buffer + offset, header,
+                                                     <uint8>(headerSize + self._readDummy), 0, <uint16>n, &sizeRead)
+            _stats_end(self._dev._stats, _OP_SPIMASTER_MULTIREADWRITE, t0, status, sizeRead)
+            if status != FT4222_OK:
+                return status
+            if sizeRead != n:
+                return FT4222_FAILED_TO_READ_DEVICE
+            offset += n
+        return FT4222_OK
+
+    cdef int _program(self, uint32 addr, const uint8* data, size_t size, uint64_t timeoutNs) noexcept nogil:
+        cdef:
+            uint8* buf = <uint8*>malloc(5 + self._pageSize)
+            size_t n, headerSize
+            size_t offset = 0
+            int status = FT4222_OK
+        if buf == NULL:
+            return FT4222_INSUFFICIENT_RESOURCES
+        while offset < size:
+            n = min(size - offset, <size_t>(self._pageSize - (addr + offset) % self._pageSize))
+            headerSize = self._header(buf, self._programCmd, addr + <uint32>offset)
+            memcpy(buf + headerSize, data + offset, n)
+            status = self._writeEnable()
+            if status == FT4222_OK:
+                status = self._single(NULL, buf, headerSize + n, True)
+            if status == FT4222_OK:
+                status = self._waitReady(timeoutNs)
+            if status != FT4222_OK:
+                break
+            offset += n
+        free(buf)
+        return status
+
+    cdef int _erase(self, uint8 cmd, uint32 addr, uint32 blockSize, size_t count, uint64_t timeoutNs) noexcept nogil:
+        cdef:
+            uint8 header[5]
+            size_t i, headerSize
+            int status = FT4222_OK
+        for i in range(count):
+            headerSize = self._header(header, cmd, addr + <uint32>(i * blockSize))
+            status = self._writeEnable()
+            if status == FT4222_OK:
+                status = self._single(NULL, header, headerSize, True)
+            if status == FT4222_OK:
+                status = self._waitReady(timeoutNs)
+            if status != FT4222_OK:
+                break
+        return status
+
+    cdef int _verify(self, uint32 addr, const uint8* data, size_t size, size_t* mismatch) noexcept nogil:
+        cdef:
+            uint8* buf = <uint8*>malloc(FLASH_CHUNK)
+            size_t n, i
+            size_t offset = 0
+            int status = FT4222_OK
+        mismatch[0] = size
+        if buf == NULL:
+            return FT4222_INSUFFICIENT_RESOURCES
+        while offset < size:
+            n = min(size - offset, <size_t>FLASH_CHUNK)
+            status = self._read(addr + <uint32>offset, buf, n)
+            if status != FT4222_OK:
+                break
+            if memcmp(buf, data + offset, n) != 0:
+                for i in range(n):
+                    if buf[i] != data[offset + i]:
+                        mismatch[0] = offset + i
+                        break
+                break
+            offset += n
+        free(buf)
+        return status
+
+    cdef _check(self, int status):
+        if status == FLASH_TIMEOUT:
+            raise TimeoutError("flash is still busy")
+        if status != FT4222_OK:
+            raise FT4222DeviceError, status
+
+    def _transfer(self, data, size_t bytesToRead=0):
+        """Send a command in single mode and read the response, returns bytes"""
+        cdef:
+            const uint8[::1] view = _data_view(data, "data")
+            const uint8* cdata = &view[0] if view.shape[0] > 0 else NULL
+            size_t size = view.shape[0]
+            bytes buf = PyBytes_FromStringAndSize(NULL, bytesToRead)
+            uint8* cbuf = <uint8*>PyBytes_AS_STRING(buf)
+            int status
+        self._dev._acquire()
+        with nogil:
+            status = self._single(NULL, cdata, size, bytesToRead == 0)
+            if status == FT4222_OK and bytesToRead > 0:
+                status = self._single(cbuf, NULL, bytesToRead, True)
+        self._dev._release()
+        self._check(status)
+        return buf
+
+    def _readinto(self, uint32 addr, uint8[::1] buffer):
+        cdef int status
+        cdef size_t size = buffer.shape[0]
+        if size == 0:
+            return 0
+        self._dev._acquire()
+        with nogil:
+            status = self._read(addr, &buffer[0], size)
+        self._dev._release()
+        self._check(status)
+        return size
+
+    def _programData(self, uint32 addr, data, double timeout):
+        cdef:
+            const uint8[::1] view = _data_view(data, "data")
+            size_t size = view.shape[0]
+            uint64_t timeoutNs = <uint64_t>(timeout * 1e9)
+            int status = FT4222_OK
+        if size == 0:
+            return
+        self._dev._acquire()
+        with nogil:
+            status = self._program(addr, &view[0], size, timeoutNs)
+        self._dev._release()
+        self._check(status)
+
+    def _eraseBlocks(self, uint8 cmd, uint32 addr, uint32 blockSize, size_t count, double timeout):
+        cdef int status
+        cdef uint64_t timeoutNs = <uint64_t>(timeout * 1e9)
+        self._dev._acquire()
+        with nogil:
+            status = self._erase(cmd, addr, blockSize, count, timeoutNs)
+        self._dev._release()
+        self._check(status)
+
+    def _waitIdle(self, double timeout):
+        cdef int status
+        cdef uint64_t timeoutNs = <uint64_t>(timeout * 1e9)
+        self._dev._acquire()
+        with nogil:
+            status = self._waitReady(timeoutNs)
+        self._dev._release()
+        self._check(status)
+
+    def _verifyData(self, uint32 addr, data):
+        cdef:
+            const uint8[::1] view = _data_view(data, "data")
+            size_t size = view.shape[0]
+            size_t mismatch = 0
+            int status = FT4222_OK
+        if size == 0:
+            return None
+        self._dev._acquire()
+        with nogil:
+            status = self._verify(addr, &view[0], size, &mismatch)
+        self._dev._release()
+        self._check(status)
+        return None if mismatch == size else mismatch
+
+
+DEF EEPROM_TIMEOUT = -1
+
+cdef class _I2CEEPROM:
+    """Native part of :class:`ft4222.eeprom.I2CEEPROM`.
+
+    Runs whole write, read and verify operations without the GIL, the device must be
+    initialized as I2C master.
+    """
+    cdef FT4222 _dev
+    cdef uint16 _addr
+    cdef uint32 _size
+    cdef uint32 _pageSize
+    cdef uint8 _addrBytes
+    cdef uint32 _pollInterval
+
+    def __cinit__(self, FT4222 dev, *args, **kwargs):
+        self._dev = dev
+        self._addr = 0x50
+        self._size = 256
+        self._pageSize = 8
+        self._addrBytes = 1
+        self._pollInterval = 0
+
+    def _configure(self, uint16 addr, uint32 size, uint32 pageSize, uint8 addrBytes, uint32 pollInterval):
+        if addrBytes not in (1, 2) or pageSize == 0 or size == 0 or size % pageSize:
+            raise ValueError("invalid EEPROM configuration")
+        if addrBytes == 1 and size > 2048:
+            raise ValueError("EEPROMs with 1 address byte have up to 2048 bytes")
+        self._addr = addr
+        self._size = size
+        self._pageSize = pageSize
+        self._addrBytes = addrBytes
+        self._pollInterval = pollInterval
+
+    cdef size_t _header(self, uint8* buf, uint32 memAddr, uint16* devAddr) noexcept nogil:
+        """Address bytes of memAddr, the bits above 8 go into the slave address with 1 address byte"""
+        if self._addrBytes == 1:
+            devAddr[0] = self._addr | ((memAddr >> 8) & 0x7)
+            buf[0] = memAddr & 0xFF
+            return 1
+        devAddr[0] = self._addr
+        buf[0] = (memAddr >> 8) & 0xFF
+        buf[1] = memAddr & 0xFF
+        return 2
+
+    cdef int _send(self, uint16 devAddr, uint8* buf, uint16 size, uint64_t timeoutNs) noexcept nogil:
+        """Write, retrying while the slave address is not acknowledged (write cycle in progress)"""
+        cdef:
+            FT_HANDLE handle = self._dev._handle
+            _OpStats* stats = self._dev._stats
+            uint64_t deadline = _monotonic_ns() + timeoutNs
+            uint64_t t0
+            uint16 sizeTransferred
+            uint8 cs
+            FT4222_STATUS status, writeStatus
+        while True:
+            t0 = _stats_begin(stats)
+            writeStatus = FT4222_I2CMaster_WriteEx(handle, devAddr, I2C_MasterFlag.START_AND_STOP, buf, size, &sizeTransferred)
+            _stats_end(stats, _OP_I2CMASTER_WRITEEX, t0, writeStatus, sizeTransferred)
+            while True:
+                t0 = _stats_begin(stats)
+                status = FT4222_I2CMaster_GetStatus(handle, &cs)
+                _stats_end(stats, _OP_I2CMASTER_GETSTATUS, t0, status, 0)
+                if status != FT4222_OK:
+                    return status
+                if not (cs & 0x01):  # BUSY
+                    break
+                # a slave stretching the clock forever or a bus held low keeps the controller busy
+                if _monotonic_ns() > deadline:
+                    return EEPROM_TIMEOUT
+            if not (cs & 0x04):  # ADDRESS_NACK
+                if writeStatus != FT4222_OK:
+                    return writeStatus
+                if sizeTransferred != size or (cs & 0x02):  # ERROR
+                    return FT4222_FAILED_TO_WRITE_DEVICE
+                return FT4222_OK
+            if _monotonic_ns() > deadline:
+                return EEPROM_TIMEOUT
+            if self._pollInterval > 0:
+                _sleep_us(self._pollInterval)
+
+    cdef int _write(self, uint32 memAddr, const uint8* data, size_t size, uint64_t timeoutNs) noexcept nogil:
+        cdef:
+            uint8* buf = <uint8*>malloc(2 + self._pageSize)
+            size_t n, headerSize
+            size_t offset = 0
+            uint16 devAddr
+            int status = FT4222_OK
+        if buf == NULL:
+            return FT4222_INSUFFICIENT_RESOURCES
+        while offset < size:
+            n = min(size - offset, <size_t>(self._pageSize - (memAddr + offset) % self._pageSize))
+            headerSize = self._header(buf, memAddr + <uint32>offset, &devAddr)
+            memcpy(buf + headerSize, data + offset, n)
+            status = self._send(devAddr, buf, <uint16>(headerSize + n), timeoutNs)
+            if status != FT4222_OK:
+                break
+            offset += n
+        if status == FT4222_OK and size > 0:
+            # acknowledge polling: wait until the last write cycle is done
+            headerSize = self._header(buf, memAddr, &devAddr)
+            status = self._send(devAddr, buf, <uint16>headerSize, timeoutNs)
+        free(buf)
+        return status
+
+    cdef int _read(self, uint32 memAddr, uint8* buffer, size_t size) noexcept nogil:
+        cdef:
+            FT_HANDLE handle = self._dev._handle
+            _OpStats* stats = self._dev._stats
+            uint8 header[2]
+            size_t n, headerSize
+            size_t offset = 0
+            uint16 devAddr, sizeTransferred
+            FT4222_STATUS status
+            uint64_t t0
+        while offset < size:
+            n = min(size - offset, <size_t>0xFFFF)
+            if self._addrBytes == 1:
+                # the slave address changes every 256 bytes
+                n = min(n, 256 - (memAddr + offset) % 256)
+            headerSize = self._header(header, memAddr + <uint32>offset, &devAddr)
+            t0 = _stats_begin(stats)
+            status = FT4222_I2CMaster_WriteEx(handle, devAddr, I2C_MasterFlag.START, header, <uint16>headerSize, &sizeTransferred)
+            _stats_end(stats, _OP_I2CMASTER_WRITEEX, t0, status, sizeTransferred)
+            if status != FT4222_OK:
+                return status
+            if sizeTransferred != headerSize:
+                return FT4222_FAILED_TO_WRITE_DEVICE
+            t0 = _stats_begin(stats)
+            status = FT4222_I2CMaster_ReadEx(handle, devAddr, I2C_MasterFlag.Repeated_START | I2C_MasterFlag.STOP,
+                                             buffer + offset, <uint16>n, &sizeTransferred)
+            _stats_end(stats, _OP_I2CMASTER_READEX, t0, status, sizeTransferred)
+            if status != FT4222_OK:
+                return status
+            if sizeTransferred != n:
+                return FT4222_FAILED_TO_READ_DEVICE
+            offset += n
+        return FT4222_OK
+
+    cdef int _verify(self, uint32 memAddr, const uint8* data, size_t size, size_t* mismatch) noexcept nogil:
+        cdef:
+            uint8* buf = <uint8*>malloc(min(size, <size_t>0xFFFF))
+            size_t n, i
+            size_t offset = 0
+            int status = FT4222_OK
+        mismatch[0] = size
+        if buf == NULL:
+            return FT4222_INSUFFICIENT_RESOURCES
+        while offset < size:
+            n = min(size - offset, <size_t>0xFFFF)
+            status = self._read(memAddr + <uint32>offset, buf, n)
+            if status != FT4222_OK:
+                break
+            if memcmp(buf, data + offset, n) != 0:
+                for i in range(n):
+                    if buf[i] != data[offset + i]:
+                        mismatch[0] = offset + i
+                        break
+                break
+            offset += n
+        free(buf)
+        return status
+
+    cdef _check(self, int status):
+        if status == EEPROM_TIMEOUT:
+            raise TimeoutError("EEPROM did not respond in time")
+        if status != FT4222_OK:
+            raise FT4222DeviceError, status
+
+    cdef _range(self, uint32 memAddr, size_t size):
+        if memAddr + size > self._size:
+            raise ValueError("range exceeds the size of the EEPROM")
+
+    def _readinto(self, uint32 memAddr, uint8[::1] buffer):
+        cdef int status
+        cdef size_t size = buffer.shape[0]
+        self._range(memAddr, size)
+        if size == 0:
+            return 0
+        self._dev._acquire()
+        with nogil:
+            status = self._read(memAddr, &buffer[0], size)
+        self._dev._release()
+        self._check(status)
+        return size
+
+    def _writeData(self, uint32 memAddr, data, double timeout):
+        cdef:
+            const uint8[::1] view = _data_view(data, "data")
+            size_t size = view.shape[0]
+            uint64_t timeoutNs = <uint64_t>(timeout * 1e9)
+            int status
+        self._range(memAddr, size)
+        if size == 0:
+            return
+        self._dev._acquire()
+        with nogil:
+            status = self._write(memAddr, &view[0], size, timeoutNs)
+        self._dev._release()
+        self._check(status)
+
+    def _verifyData(self, uint32 memAddr, data):
+        cdef:
+            const uint8[::1] view = _data_view(data, "data")
+            size_t size = view.shape[0]
+            size_t mismatch = 0
+            int status
+        self._range(memAddr, size)
+        if size == 0:
+            return None
+        self._dev._acquire()
+        with nogil:
+            status = self._verify(memAddr, &view[0], size, &mismatch)
+        self._dev._release()
+        self._check(status)
+        return None if mismatch == size else mismatch
+
+
+cdef enum _RegBus:
+    _REG_BUS_I2C
+    _REG_BUS_SPI
+
+cdef struct _Reg:
+    uint32 offset      # byte offset, address * addrUnit
+    uint8 width
+    bint little
+    bint volatile
+    bint valid
+    bint dirty
+    bint selected
+    uint64_t value
+
+cdef class RegisterMap:
+    """Register map of an I2C or SPI slave with a write-back shadow cache.
+
+    The registers are described once, each as a tuple ``(name, address, width=1,
+    byteorder=None, volatile=False)`` with the width in bytes (1 to 8) and the byteorder
+    ``'big'`` or ``'little'`` (None for the default of the map). Values are cached; reads of
+    non-volatile registers are served from the cache once fetched, writes only update the
+    cache and mark the register dirty until :meth:`flush`. Read-modify-writes with
+    :meth:`update` therefore cost at most one read, no matter how often they are repeated.
+
+    :meth:`fetch` and :meth:`flush` coalesce registers with adjacent addresses into burst
+    transfers (relying on the address auto-increment of the slave) and run without the GIL.
+    The map can't be used from other threads while they run.
+
+    On I2C the register address (addrWidth bytes, big endian) is written, followed by the
+    data or a repeated start and the read. On SPI the register address is sent in single
+    mode with readFlag or writeFlag or'ed into its first byte, followed by the data.
+
+    Example::
+
+        regs = ft4222.RegisterMap(dev, [
+            ('CTRL', 0x00),
+            ('STATUS', 0x01, 1, None, True),
+            ('THRESHOLD', 0x02, 2, 'little'),
+        ], slaveAddr=0x20)
+        regs.fetch()
+        with regs:
+            regs.update('CTRL', 0x03, 0x01)
+            regs['THRESHOLD'] = 1000
+        # one burst write of CTRL (and THRESHOLD if adjacent)
+
+    Args:
+        dev (:obj:`FT4222`): Device initialized as I2C or SPI master
+        registers (list): Register descriptions
+        slaveAddr (int): Slave address on I2C, None for SPI
+        addrWidth (int): Register address bytes
+        addrUnit (int): Bytes per address step (2 for slaves addressing 16 bit words)
+        byteorder (str): Default byteorder of the registers
+        readFlag (int): SPI only, or'ed into the first address byte for reads
+        writeFlag (int): SPI only, or'ed into the first address byte for writes
+
+    """
+    cdef FT4222 _dev
+    cdef _RegBus _bus
+    cdef uint16 _slaveAddr
+    cdef uint8 _addrWidth
+    cdef uint8 _addrUnit
+    cdef uint8 _readFlag
+    cdef uint8 _writeFlag
+    cdef _Reg* _regs
+    cdef size_t _nregs
+    cdef uint8* _buffer
+    cdef uint8* _rbuffer
+    cdef dict _index
+    cdef size_t _executing
+
+    def __cinit__(self):
+        self._regs = NULL
+        self._buffer = NULL
+        self._rbuffer = NULL
+        self._executing = 0
+
+    def __init__(self, FT4222 dev, registers, slaveAddr=None, uint8 addrWidth=1, uint8 addrUnit=1,
+                 byteorder='big', uint8 readFlag=0x80, uint8 writeFlag=0x00):
+        cdef size_t i, total = 0
+        cdef _Reg* reg
+        self._checkIdle()
+        if addrWidth < 1 or addrWidth > 4 or addrUnit < 1:
+            raise ValueError("invalid address width or unit")
+        self._dev = dev
+        self._bus = _REG_BUS_SPI if slaveAddr is None else _REG_BUS_I2C
+        self._slaveAddr = 0 if slaveAddr is None else slaveAddr
+        self._addrWidth = addrWidth
+        self._addrUnit = addrUnit
+        self._readFlag = readFlag if slaveAddr is None else 0
+        self._writeFlag = writeFlag if slaveAddr is None else 0
+        descs = []
+        for desc in registers:
+            desc = tuple(desc)
+            name, addr, width, order, volatile = desc + (1, None, False)[len(desc) - 2:]
+            if not 1 <= width <= 8:
+                raise ValueError("width of register {} must be 1 to 8 bytes".format(name))
+            order = order or byteorder
+            if order not in ('big', 'little'):
+                raise ValueError("byteorder must be 'big' or 'little'")
+            descs.append((addr * addrUnit, width, order == 'little', bool(volatile), name))
+        descs.sort(key=lambda d: d[0])
+        for prev, desc in zip(descs, descs[1:]):
+            if desc[0] < prev[0] + prev[1]:
+                raise ValueError("registers {} and {} overlap".format(prev[4], desc[4]))
+        free(self._regs)
+        free(self._buffer)
+        free(self._rbuffer)
+        self._nregs = len(descs)
+        self._regs = <_Reg*>calloc(max(self._nregs, <size_t>1), sizeof(_Reg))
+        for d in descs:
+            total += d[1]
+        self._buffer = <uint8*>malloc(4 + total)
+        self._rbuffer = <uint8*>malloc(4 + total)
+        if self._regs == NULL or self._buffer == NULL or self._rbuffer == NULL:
+            raise MemoryError()
+        self._index = {}
+        for i in range(self._nregs):
+            reg = &self._regs[i]
+            reg.offset, reg.width, reg.little, reg.volatile, name = descs[i]
+            self._index[name] = i
+
+    def __dealloc__(self):
+        free(self._regs)
+        free(self._buffer)
+        free(self._rbuffer)
+
+    cdef int _checkIdle(self) except -1:
+        if self._executing:
+            raise RuntimeError("register map is being transferred")
+        return 0
+
+    cdef size_t _lookup(self, name) except? 0:
+        try:
+            return self._index[name]
+        except KeyError:
+            raise KeyError("unknown register {!r}".format(name)) from None
+
+    cdef size_t _header(self, uint32 offset, uint8 flag) noexcept nogil:
+        cdef uint32 addr = offset // self._addrUnit
+        cdef size_t i
+        for i in range(self._addrWidth):
+            self._buffer[i] = (addr >> (8 * (self._addrWidth - 1 - i))) & 0xFF
+        self._buffer[0] |= flag
+        return self._addrWidth
+
+    cdef size_t _run(self, size_t first, bint dirty) noexcept nogil:
+        """Number of registers from first on which can be transferred in one burst"""
+        cdef size_t last = first
+        cdef size_t size = self._regs[first].width
+        while last + 1 < self._nregs:
+            if (self._regs[last + 1].dirty if dirty else self._regs[last + 1].selected) == 0:
+                break
+            if self._regs[last + 1].offset != self._regs[last].offset + self._regs[last].width:
+                break
+            if size + self._regs[last + 1].width > 0xFFFF - 4:
+                break
+            last += 1
+            size += self._regs[last].width
+        return last - first + 1
+
+    cdef int _transfer(self, uint32 offset, size_t size, bint read) noexcept nogil:
+        """Burst transfer of size bytes at offset, the data is after the header in _buffer
+        for writes and in _rbuffer for reads"""
+        cdef:
+            FT_HANDLE handle = self._dev._handle
+            _OpStats* stats = self._dev._stats
+            size_t headerSize = self._header(offset, self._readFlag if read else self._writeFlag)
+            size_t done
+            uint16 sizeTransferred
+            FT4222_STATUS status
+            uint64_t t0
+        if self._bus == _REG_BUS_SPI:
+            if not read:
+                status = self._dev._spiMaster_Single(NULL, self._buffer, headerSize + size, &done, True)
+            else:
+                memset(self._buffer + headerSize, 0, size)
+                status = self._dev._spiMaster_Single(self._rbuffer, self._buffer, headerSize + size, &done, True)
+            if status == FT4222_OK and done != headerSize + size:
+                return FT4222_FAILED_TO_READ_DEVICE if read else FT4222_FAILED_TO_WRITE_DEVICE
+            return status
+        if not read:
+            t0 = _stats_begin(stats)
+            status = FT4222_I2CMaster_WriteEx(handle, self._slaveAddr, I2C_MasterFlag.START_AND_STOP,
+                                              self._buffer, <uint16>(headerSize + size), &sizeTransferred)
+            _stats_end(stats, _OP_I2CMASTER_WRITEEX, t0, status, sizeTransferred)
+            if status == FT4222_OK and sizeTransferred != headerSize + size:
+                return FT4222_FAILED_TO_WRITE_DEVICE
+            return status
+        t0 = _stats_begin(stats)
+        status = FT4222_I2CMaster_WriteEx(handle, self._slaveAddr, I2C_MasterFlag.START,
+                                          self._buffer, <uint16>headerSize, &sizeTransferred)
+        _stats_end(stats, _OP_I2CMASTER_WRITEEX, t0, status, sizeTransferred)
+        if status != FT4222_OK:
+            return status
+        if sizeTransferred != headerSize:
+            return FT4222_FAILED_TO_WRITE_DEVICE
+        t0 = _stats_begin(stats)
+        status = FT4222_I2CMaster_ReadEx(handle, self._slaveAddr, I2C_MasterFlag.Repeated_START | I2C_MasterFlag.STOP,
+                                         self._rbuffer + headerSize, <uint16>size, &sizeTransferred)
+        _stats_end(stats, _OP_I2CMASTER_READEX, t0, status, sizeTransferred)
+        if status == FT4222_OK and sizeTransferred != size:
+            return FT4222_FAILED_TO_READ_DEVICE
+        return status
+
+    cdef int _fetch(self) noexcept nogil:
+        """Read all selected registers"""
+        cdef:
+            size_t i = 0, j, k, n, pos
+            _Reg* reg
+            int status
+        while i < self._nregs:
+            if not self._regs[i].selected:
+                i += 1
+                continue
+            n = self._run(i, False)
+            reg = &self._regs[i + n - 1]
+            status = self._transfer(self._regs[i].offset, reg.offset + reg.width - self._regs[i].offset, True)
+            if status != FT4222_OK:
+                return status
+            pos = self._addrWidth
+            for j in range(i, i + n):
+                reg = &self._regs[j]
+                reg.value = 0
+                for k in range(reg.width):
+                    if reg.little:
+                        reg.value |= <uint64_t>self._rbuffer[pos + k] << (8 * k)
+                    else:
+                        reg.value = (reg.value << 8) | self._rbuffer[pos + k]
+                pos += reg.width
+                reg.valid = True
+                reg.dirty = False
+                reg.selected = False
+            i += n
+        return FT4222_OK
+
+    cdef int _flush(self) noexcept nogil:
+        """Write all dirty registers"""
+        cdef:
+            size_t i = 0, j, k, n, pos
+            _Reg* reg
+            int status
+        while i < self._nregs:
+            if not self._regs[i].dirty:
+                i += 1
+                continue
+            n = self._run(i, True)
+            pos = self._addrWidth
+            for j in range(i, i + n):
+                reg = &self._regs[j]
+                for k in range(reg.width):
+                    if reg.little:
+                        self._buffer[pos + k] = (reg.value >> (8 * k)) & 0xFF
+                    else:
+                        self._buffer[pos + k] = (reg.value >> (8 * (reg.width - 1 - k))) & 0xFF
+                pos += reg.width
+            status = self._transfer(self._regs[i].offset, pos - self._addrWidth, False)
+            if status != FT4222_OK:
+                return status
+            for j in range(i, i + n):
+                self._regs[j].dirty = False
+            i += n
+        return FT4222_OK
+
+    def fetch(self, names=None):
+        """Read registers from the device into the cache.
+
+        Dirty registers are not read, their cached value would be lost.
+
+        Args:
+            names (list): Names of the registers to read, None for all
+
+        Raises:
+            FT4222DeviceError: on error
+            RuntimeError: if a transfer of the map is already running
+
+        """
+        cdef size_t i
+        cdef int status
+        self._checkIdle()
+        if names is None:
+            for i in range(self._nregs):
+                self._regs[i].selected = not self._regs[i].dirty
+        else:
+            for name in names:
+                i = self._lookup(name)
+                self._regs[i].selected = not self._regs[i].dirty
+        # the registers and buffers must not be touched while the transfer runs
+        self._executing += 1
+        try:
+            self._dev._acquire()
+            with nogil:
+                status = self._fetch()
+            self._dev._release()
+        finally:
+            self._executing -= 1
+        if status != FT4222_OK:
+            for i in range(self._nregs):
+                self._regs[i].selected = False
+            raise FT4222DeviceError, status
+
+    def flush(self):
+        """Write all dirty registers to the device.
+
+        Raises:
+            FT4222DeviceError: on error
+            RuntimeError: if a transfer of the map is already running
+
+        """
+        cdef int status
+        self._checkIdle()
+        self._executing += 1
+        try:
+            self._dev._acquire()
+            with nogil:
+                status = self._flush()
+            self._dev._release()
+        finally:
+            self._executing -= 1
+        if status != FT4222_OK:
+            raise FT4222DeviceError, status
+
+    def invalidate(self, names=None):
+        """Drop cached values, pending writes are discarded as well.
+
+        Args:
+            names (list): Names of the registers, None for all
+
+        """
+        cdef size_t i
+        self._checkIdle()
+        for i in (range(self._nregs) if names is None else [self._lookup(n) for n in names]):
+            self._regs[i].valid = False
+            self._regs[i].dirty = False
+
+    def get(self, name):
+        """Get the value of a register.
+
+        Volatile registers and registers not cached yet are read from the device.
+
+        Args:
+            name (str): Register name
+
+        Returns:
+            int: Value
+
+        Raises:
+            FT4222DeviceError: on error
+
+        """
+        cdef size_t i = self._lookup(name)
+        self._checkIdle()
+        if self._regs[i].dirty or (self._regs[i].valid and not self._regs[i].volatile):
+            return self._regs[i].value
+        self.fetch((name,))
+        return self._regs[i].value
+
+    def set(self, name, uint64_t value):
+        """Set the value of a register, it is written on :meth:`flush`.
+
+        Args:
+            name (str): Register name
+            value (int): Value
+
+        """
+        cdef size_t i = self._lookup(name)
+        cdef _Reg* reg = &self._regs[i]
+        self._checkIdle()
+        if reg.width < 8 and value >> (8 * reg.width):
+            raise ValueError("value does not fit into register {}".format(name))
+        reg.value = value
+        reg.valid = True
+        reg.dirty = True
+
+    def update(self, name, uint64_t mask, uint64_t value):
+        """Read-modify-write the bits in mask, it is written on :meth:`flush`.
+
+        Args:
+            name (str): Register name
+            mask (int): Bits to change
+            value (int): New value of the bits in mask
+
+        Raises:
+            FT4222DeviceError: on error
+
+        """
+        self.set(name, (self.get(name) & ~mask) | (value & mask))
+
+    @property
+    def dirty(self):
+        """:obj:`list` of :obj:`str`: Names of the registers waiting to be written"""
+        self._checkIdle()
+        return [name for name, i in self._index.items() if self._regs[<size_t>i].dirty]
+
+    def __getitem__(self, name):
+        return self.get(name)
+
+    def __setitem__(self, name, value):
+        self.set(name, value)
+
+    def __contains__(self, name):
+        return name in self._index
+
+    def __iter__(self):
+        return iter(self._index)
+
+    def __len__(self):
+        return self._nregs
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, exc_type, *exc):
+        if exc_type is None:
+            self.flush()
+
+
+cdef extern from *:
+    """
+    /* Intrusive multi-producer/single-consumer queue (D. Vyukov). Producers never block, a push
+       is one atomic exchange. The consumer may see an empty queue for a moment while a push is
+       half done, ft4222_mpsc_empty() tells that case apart. */
+    #if defined(_WIN32)
+    #include <windows.h>
+    #else
+    #include <pthread.h>
+    #include <time.h>
+    #endif
+
+    typedef struct ft4222_mpsc_node { struct ft4222_mpsc_node* next; } ft4222_mpsc_node;
+    typedef struct { ft4222_mpsc_node* head; ft4222_mpsc_node* tail; ft4222_mpsc_node stub; } ft4222_mpsc;
+
+    #if defined(_MSC_VER)
+    #define FT4222_XCHG_PTR(p, v) InterlockedExchangePointer((PVOID volatile*)(p), (v))
+    #define FT4222_LOAD_PTR(p) InterlockedCompareExchangePointer((PVOID volatile*)(p), NULL, NULL)
+    #define FT4222_STORE_PTR(p, v) InterlockedExchangePointer((PVOID volatile*)(p), (v))
+    #else
+    #define FT4222_XCHG_PTR(p, v) __atomic_exchange_n((p), (v), __ATOMIC_SEQ_CST)
+    #define FT4222_LOAD_PTR(p) __atomic_load_n((p), __ATOMIC_SEQ_CST)
+    #define FT4222_STORE_PTR(p, v) __atomic_store_n((p), (v), __ATOMIC_RELEASE)
+    #endif
+
+    static void ft4222_mpsc_init(ft4222_mpsc* q) {
+        q->stub.next = NULL;
+        q->head = q->tail = &q->stub;
+    }
+
+    static void ft4222_mpsc_push(ft4222_mpsc* q, ft4222_mpsc_node* node) {
+        ft4222_mpsc_node* prev;
+        node->next = NULL;
+        prev = (ft4222_mpsc_node*)FT4222_XCHG_PTR(&q->head, node);
+        FT4222_STORE_PTR(&prev->next, node);
+    }
+
+    static int ft4222_mpsc_empty(ft4222_mpsc* q) {
+        return q->tail == &q->stub && FT4222_LOAD_PTR(&q->head) == (void*)&q->stub;
+    }
+
+    static ft4222_mpsc_node* ft4222_mpsc_pop(ft4222_mpsc* q) {
+        ft4222_mpsc_node* tail = q->tail;
+        ft4222_mpsc_node* next = (ft4222_mpsc_node*)FT4222_LOAD_PTR(&tail->next);
+        if (tail == &q->stub) {
+            if (next == NULL)
+                return NULL;
+            q->tail = tail = next;
+            next = (ft4222_mpsc_node*)FT4222_LOAD_PTR(&next->next);
+        }
+        if (next != NULL) {
+            q->tail = next;
+            return tail;
+        }
+        if (tail != FT4222_LOAD_PTR(&q->head))
+            return NULL;
+        ft4222_mpsc_push(q, &q->stub);
+        next = (ft4222_mpsc_node*)FT4222_LOAD_PTR(&tail->next);
+        if (next == NULL)
+            return NULL;
+        q->tail = next;
+        return tail;
+    }
+
+    /* mutex and condition variable */
+    #if defined(_WIN32)
+    typedef struct { SRWLOCK lock; CONDITION_VARIABLE cond; } ft4222_signal;
+    static void ft4222_signal_init(ft4222_signal* s) { InitializeSRWLock(&s->lock); InitializeConditionVariable(&s->cond); }
+    static void ft4222_signal_destroy(ft4222_signal* s) { (void)s; }
+    static void ft4222_signal_lock(ft4222_signal* s) { AcquireSRWLockExclusive(&s->lock); }
+    static void ft4222_signal_unlock(ft4222_signal* s) { ReleaseSRWLockExclusive(&s->lock); }
+    static void ft4222_signal_notify(ft4222_signal* s) { WakeAllConditionVariable(&s->cond); }
+    static void ft4222_signal_wait(ft4222_signal* s, unsigned long ms) { SleepConditionVariableSRW(&s->cond, &s->lock, ms, 0); }
+    #else
+    typedef struct { pthread_mutex_t lock; pthread_cond_t cond; } ft4222_signal;
+    static void ft4222_signal_init(ft4222_signal* s) { pthread_mutex_init(&s->lock, NULL); pthread_cond_init(&s->cond, NULL); }
+    static void ft4222_signal_destroy(ft4222_signal* s) { pthread_cond_destroy(&s->cond); pthread_mutex_destroy(&s->lock); }
+    static void ft4222_signal_lock(ft4222_signal* s) { pthread_mutex_lock(&s->lock); }
+    static void ft4222_signal_unlock(ft4222_signal* s) { pthread_mutex_unlock(&s->lock); }
+    static void ft4222_signal_notify(ft4222_signal* s) { pthread_cond_broadcast(&s->cond); }
+    static void ft4222_signal_wait(ft4222_signal* s, unsigned long ms) {
+        struct timespec ts;
+        if (ms == 0xFFFFFFFFUL) {
+            pthread_cond_wait(&s->cond, &s->lock);
+            return;
+        }
+        clock_gettime(CLOCK_REALTIME, &ts);
+        ts.tv_sec += ms / 1000;
+        ts.tv_nsec += (long)(ms % 1000) * 1000000L;
+        if (ts.tv_nsec >= 1000000000L) {
+            ts.tv_sec += 1;
+            ts.tv_nsec -= 1000000000L;
+        }
+        pthread_cond_timedwait(&s->cond, &s->lock, &ts);
+    }
+    #endif
+
+    #if defined(_MSC_VER)
+    #define ft4222_atomic_load_sc(p) ((size_t)InterlockedCompareExchangePointer((PVOID volatile*)(p), NULL, NULL))
+    #define ft4222_atomic_store_sc(p, v) InterlockedExchangePointer((PVOID volatile*)(p), (PVOID)(size_t)(v))
+    #else
+    #define ft4222_atomic_load_sc(p) __atomic_load_n((p), __ATOMIC_SEQ_CST)
+    #define ft4222_atomic_store_sc(p, v) __atomic_store_n((p), (v), __ATOMIC_SEQ_CST)
+    #endif
+
+    /* add 1 to the counter of an eventfd (or anything else an 8-byte write wakes up) */
+    #if defined(_WIN32)
+    #include <io.h>
+    static void ft4222_notify_fd(int fd) { uint64_t one = 1; _write(fd, &one, 8); }
+    #else
+    #include <unistd.h>
+    static void ft4222_notify_fd(int fd) { uint64_t one = 1; ssize_t n = write(fd, &one, 8); (void)n; }
+    #endif
+    """
+    ctypedef struct _MpscNode "ft4222_mpsc_node":
+        pass
+    ctypedef struct _Mpsc "ft4222_mpsc":
+        pass
+    void _mpsc_init "ft4222_mpsc_init" (_Mpsc* q) noexcept nogil
+    void _mpsc_push "ft4222_mpsc_push" (_Mpsc* q, _MpscNode* node) noexcept nogil
+    _MpscNode* _mpsc_pop "ft4222_mpsc_pop" (_Mpsc* q) noexcept nogil
+    bint _mpsc_empty "ft4222_mpsc_empty" (_Mpsc* q) noexcept nogil
+
+    ctypedef struct _Signal "ft4222_signal":
+        pass
+    void _signal_init "ft4222_signal_init" (_Signal* s) noexcept nogil
+    void _signal_destroy "ft4222_signal_destroy" (_Signal* s) noexcept nogil
+    void _signal_lock "ft4222_signal_lock" (_Signal* s) noexcept nogil
+    void _signal_unlock "ft4222_signal_unlock" (_Signal* s) noexcept nogil
+    void _signal_notify "ft4222_signal_notify" (_Signal* s) noexcept nogil
+    void _signal_wait "ft4222_signal_wait" (_Signal* s, unsigned long ms) noexcept nogil
+
+    size_t _atomic_load_sc "ft4222_atomic_load_sc" (size_t* p) noexcept nogil
+    void _atomic_store_sc "ft4222_atomic_store_sc" (size_t* p, size_t v) noexcept nogil
+
+    void _notify_fd "ft4222_notify_fd" (int fd) noexcept nogil
+
+
+cdef enum _CmdKind:
+    _CMD_SPI_READ
+    _CMD_SPI_WRITE
+    _CMD_SPI_READWRITE
+    _CMD_SPI_MULTI
+    _CMD_I2C_READ
+    _CMD_I2C_WRITE
+    _CMD_I2C_READEX
+    _CMD_I2C_WRITEEX
+    _CMD_I2C_GETSTATUS
+    _CMD_GPIO_READ
+    _CMD_GPIO_WRITE
+    _CMD_CALL
+
+cdef class CommandQueue
+
+cdef struct _Cmd:
+    _MpscNode node  # must stay the first member
+    void* owner
+    _CmdKind kind
+    uint16 addr
+    uint8 flag
+    uint8 singleSize
+    bint isEnd
+    uint8* wbuf
+    uint8* rbuf
+    size_t size
+    size_t done
+    uint32 value
+    FT4222_STATUS status
+    size_t complete
+
+
+cdef class CommandFuture:
+    """Result of a command queued on a :class:`CommandQueue`.
+
+    Created by the methods of :class:`CommandQueue`, not by the user.
+    """
+    cdef _Cmd _cmd
+    cdef CommandQueue _queue
+    cdef const uint8[::1] _wview
+    cdef uint8[::1] _rview
+    cdef bytes _rbytes
+    cdef uint8* _scratch
+    cdef bint _into
+    cdef object _fn, _args, _kwargs, _result, _exc
+
+    def __dealloc__(self):
+        free(self._scratch)
+
+    def done(self):
+        """Check if the command has been executed.
+
+        Returns:
+            bool: True if the result is available
+
+        """
+        return _atomic_load(&self._cmd.complete) != 0
+
+    cdef void _wait(self, double timeout) noexcept nogil:
+        cdef _Signal* signal = &self._queue._completed
+        cdef uint64_t deadline = _monotonic_ns() + <uint64_t>(timeout * 1e9) if timeout >= 0 else 0
+        cdef uint64_t now
+        _signal_lock(signal)
+        self._queue._waiters += 1
+        while not self._cmd.complete:
+            if timeout < 0:
+                _signal_wait(signal, 0xFFFFFFFFUL)
+                continue
+            now = _monotonic_ns()
+            if now >= deadline:
+                break
+            _signal_wait(signal, <unsigned long>((deadline - now) // 1000000 + 1))
+        self._queue._waiters -= 1
+        _signal_unlock(signal)
+
+    def result(self, timeout=None):
+        """Wait for the command and get its result.
+
+        The result is the same as the one of the corresponding :class:`FT4222` method.
+
+        Args:
+            timeout (float, None): Seconds to wait, None to wait forever
+
+        Returns:
+            Result of the command
+
+        Raises:
+            FT4222DeviceError: on error
+            TimeoutError: if the command has not been executed in time
+
+        """
+        cdef double t = -1 if timeout is None else timeout
+        if not _atomic_load(&self._cmd.complete):
+            with nogil:
+                self._wait(t)
+            if not _atomic_load(&self._cmd.complete):
+                raise TimeoutError("command not executed in time")
+        kind = self._cmd.kind
+        if kind == _CMD_CALL:
+            if self._exc is not None:
+                raise self._exc
+            return self._result
+        if self._cmd.status != FT4222_OK:
+            raise FT4222DeviceError, self._cmd.status
+        if kind == _CMD_GPIO_READ:
+            return bool(self._cmd.value)
+        if kind == _CMD_GPIO_WRITE:
+            return None
+        if kind == _CMD_I2C_GETSTATUS:
+            return ControllerStatus(self._cmd.value)
+        if kind in (_CMD_SPI_WRITE, _CMD_I2C_WRITE, _CMD_I2C_WRITEEX) or self._into:
+            return self._cmd.done
+        if self._cmd.done == self._cmd.size:
+            return self._rbytes
+        return self._rbytes[:self._cmd.done]
+
+    def exception(self, timeout=None):
+        """Wait for the command and get the exception it raised.
+
+        Args:
+            timeout (float, None): Seconds to wait, None to wait forever
+
+        Returns:
+            Exception: Exception of the command, None if it succeeded
+
+        Raises:
+            TimeoutError: if the command has not been executed in time
+
+        """
+        try:
+            self.result(timeout)
+        except TimeoutError:
+            if not self.done():
+                raise
+            return self._exc
+        except BaseException as e:
+            return e
+        return None
+
+
+cdef void _cmd_call(_Cmd* cmd) noexcept with gil:
+    cdef CommandFuture future = <CommandFuture>cmd.owner
+    try:
+        future._result = future._fn(*future._args, **future._kwargs)
+    except BaseException as e:
+        future._exc = e
+    future._fn = future._args = future._kwargs = None
+
+
+cdef void _cmd_callback(object callback) noexcept with gil:
+    try:
+        callback()
+    except BaseException:
+        pass
+
+
+cdef class CommandQueue:
+    """Queued mode of a :class:`FT4222`.
+
+    A worker thread owns the device handle and executes the commands in the order they
+    are submitted. Submitting never blocks: commands go into a lock-free queue and a
+    :class:`CommandFuture` is returned, so the next transfer can be prepared and queued
+    while the current one is on the wire. Several threads may submit concurrently.
+
+    The transfer methods have the same arguments as the ones of :class:`FT4222` and are
+    executed without the GIL. Every other public method of :class:`FT4222` is available as
+    well and runs in the worker thread with the GIL. The device must not be used directly
+    while the queue is open. Write data is referenced, not copied, and buffers of the
+    ``*_into`` methods are filled in place; neither may be modified until the command is
+    done::
+
+        with dev.queue() as q:
+            q.spiMaster_SingleWrite(cmd, False)
+            f = q.spiMaster_SingleRead(512, True)
+            data = f.result()
+
+    Args:
+        dev (:obj:`FT4222`): Opened device
+        notifyFd (int): File descriptor to write an 8-byte counter increment to after
+            every command, e.g. an eventfd, -1 for none
+        callback (callable): Called without arguments from the worker thread after
+            every command, None for none
+
+    """
+    cdef FT4222 _dev
+    cdef _Mpsc _pending
+    cdef _Signal _work
+    cdef _Signal _completed
+    cdef size_t _waiting
+    cdef size_t _running
+    cdef size_t _waiters
+    cdef int _notifyFd
+    cdef bint _hasCallback
+    cdef object _callback
+    cdef object _inflight
+    cdef object _thread
+
+    def __cinit__(self, FT4222 dev, int notifyFd=-1, callback=None):
+        if dev._queued:
+            raise RuntimeError("the device is already in queued mode")
+        dev._queued = True
+        self._dev = dev
+        self._notifyFd = notifyFd
+        self._callback = callback
+        self._hasCallback = callback is not None
+        self._inflight = collections.deque()
+        _mpsc_init(&self._pending)
+        _signal_init(&self._work)
+        _signal_init(&self._completed)
+        self._running = 1
+        self._thread = threading.Thread(target=self._run, name='CommandQueue', daemon=True)
+        self._thread.start()
+
+    def __dealloc__(self):
+        _signal_destroy(&self._work)
+        _signal_destroy(&self._completed)
+
+    cdef void _execute(self, _Cmd* cmd) noexcept nogil:
+        cdef:
+            FT_HANDLE handle = self._dev._handle
+            _OpStats* stats = self._dev._stats
+            uint16 done16 = 0
+            uint32 done32 = 0
+            uint8 cs
+            BOOL value
+            uint64_t t0
+        if cmd.kind == _CMD_SPI_READ:
+            cmd.status = self._dev._spiMaster_Single(cmd.rbuf, NULL, cmd.size, &cmd.done, cmd.isEnd)
+        elif cmd.kind == _CMD_SPI_WRITE:
+            cmd.status = self._dev._spiMaster_Single(NULL, cmd.wbuf, cmd.size, &cmd.done, cmd.isEnd)
+        elif cmd.kind == _CMD_SPI_READWRITE:
+            cmd.status = self._dev._spiMaster_Single(cmd.rbuf, cmd.wbuf, cmd.size, &cmd.done, cmd.isEnd)
+        elif cmd.kind == _CMD_SPI_MULTI:
+            t0 = _stats_begin(stats)
+            cmd.status = FT4222_SPIMaster_MultiReadWrite(handle, cmd.rbuf, cmd.wbuf, cmd.singleSize, <uint16>cmd.value,
+                                                         <uint16>cmd.size, &done32)
+            _stats_end(stats, _OP_SPIMASTER_MULTIREADWRITE, t0, cmd.status, done32 + cmd.singleSize + cmd.value)
+            cmd.done = done32
+        elif cmd.kind == _CMD_I2C_READ:
+            t0 = _stats_begin(stats)
+            cmd.status = FT4222_I2CMaster_Read(handle, cmd.addr, cmd.rbuf, <uint16>cmd.size, &done16)
+            _stats_end(stats, _OP_I2CMASTER_READ, t0, cmd.status, done16)
+            cmd.done = done16
+        elif cmd.kind == _CMD_I2C_WRITE:
+            t0 = _stats_begin(stats)
+            cmd.status = FT4222_I2CMaster_Write(handle, cmd.addr, cmd.wbuf, <uint16>cmd.size, &done16)
+            _stats_end(stats, _OP_I2CMASTER_WRITE, t0, cmd.status, done16)
+            cmd.done = done16
+        elif cmd.kind == _CMD_I2C_READEX:
+            t0 = _stats_begin(stats)
+            cmd.status = FT4222_I2CMaster_ReadEx(handle, cmd.addr, cmd.flag, cmd.rbuf, <uint16>cmd.size, &done16)
+            _stats_end(stats, _OP_I2CMASTER_READEX, t0, cmd.status, done16)
+            cmd.done = done16
+        elif cmd.kind == _CMD_I2C_WRITEEX:
+            t0 = _stats_begin(stats)
+            cmd.status = FT4222_I2CMaster_WriteEx(handle, cmd.addr, cmd.flag, cmd.wbuf, <uint16>cmd.size, &done16)
+            _stats_end(stats, _OP_I2CMASTER_WRITEEX, t0, cmd.status, done16)
+            cmd.done = done16
+        elif cmd.kind == _CMD_I2C_GETSTATUS:
+            t0 = _stats_begin(stats)
+            cmd.status = FT4222_I2CMaster_GetStatus(handle, &cs)
+            _stats_end(stats, _OP_I2CMASTER_GETSTATUS, t0, cmd.status, 0)
+            cmd.value = cs
+        elif cmd.kind == _CMD_GPIO_READ:
+            t0 = _stats_begin(stats)
+            cmd.status = FT4222_GPIO_Read(handle, <GPIO_Port>cmd.addr, &value)
+            _stats_end(stats, _OP_GPIO_READ, t0, cmd.status, 0)
+            cmd.value = value != 0
+        elif cmd.kind == _CMD_GPIO_WRITE:
+            t0 = _stats_begin(stats)
+            cmd.status = FT4222_GPIO_Write(handle, <GPIO_Port>cmd.addr, cmd.value != 0)
+            _stats_end(stats, _OP_GPIO_WRITE, t0, cmd.status, 0)
+        else:
+            _cmd_call(cmd)
+            cmd.status = FT4222_OK
+
+    cdef void _loop(self) noexcept nogil:
+        cdef _Cmd* cmd
+        while True:
+            cmd = <_Cmd*>_mpsc_pop(&self._pending)
+            if cmd == NULL:
+                if _mpsc_empty(&self._pending):
+                    if not _atomic_load_sc(&self._running):
+                        break
+                    # a producer which misses the flag has pushed before the queue is checked again
+                    _signal_lock(&self._work)
+                    _atomic_store_sc(&self._waiting, 1)
+                    while _mpsc_empty(&self._pending) and _atomic_load_sc(&self._running):
+                        _signal_wait(&self._work, 0xFFFFFFFFUL)
+                    _atomic_store_sc(&self._waiting, 0)
+                    _signal_unlock(&self._work)
+                # else a push is half done, retry
+                continue
+            self._execute(cmd)
+            _signal_lock(&self._completed)
+            _atomic_store(&cmd.complete, 1)
+            if self._waiters:
+                _signal_notify(&self._completed)
+            _signal_unlock(&self._completed)
+            if self._notifyFd >= 0:
+                _notify_fd(self._notifyFd)
+            elif self._hasCallback:
+                _cmd_callback(self._callback)
+
+    def _run(self):
+        with nogil:
+            self._loop()
+
+    cdef CommandFuture _new(self, _CmdKind kind):
+        if self._thread is None:
+            raise RuntimeError("command queue is closed")
+        cdef CommandFuture future = CommandFuture.__new__(CommandFuture)
+        future._queue = self
+        future._cmd.owner = <void*>future
+        future._cmd.kind = kind
+        return future
+
+    cdef CommandFuture _submit(self, CommandFuture future):
+        # keep the future alive until executed, completion is in order
+        while self._inflight and (<CommandFuture>self._inflight[0]).done():
+            self._inflight.popleft()
+        # preparing the command may have dropped the GIL, the worker is gone once closed
+        if self._thread is None:
+            raise RuntimeError("command queue is closed")
+        self._inflight.append(future)
+        _mpsc_push(&self._pending, &future._cmd.node)
+        if _atomic_load_sc(&self._waiting):
+            _signal_lock(&self._work)
+            _signal_notify(&self._work)
+            _signal_unlock(&self._work)
+        return future
+
+    cdef void _write(self, CommandFuture future, data, size_t maxSize) except *:
+        future._wview = _data_view(data, 'data')
+        if <size_t>future._wview.shape[0] > maxSize:
+            raise ValueError("data must not be larger than {} bytes".format(maxSize))
+        future._cmd.size = future._wview.shape[0]
+        future._cmd.wbuf = <uint8*>&future._wview[0] if future._cmd.size > 0 else NULL
+
+    cdef void _read(self, CommandFuture future, size_t size) except *:
+        future._rbytes = PyBytes_FromStringAndSize(NULL, size)
+        future._cmd.rbuf = <uint8*>PyBytes_AS_STRING(future._rbytes)
+        future._cmd.size = size
+
+    cdef void _readinto(self, CommandFuture future, uint8[::1] buffer, size_t maxSize) except *:
+        if <size_t>buffer.shape[0] > maxSize:
+            raise ValueError("buffer must not be larger than {} bytes".format(maxSize))
+        future._rview = buffer
+        future._into = True
+        future._cmd.size = buffer.shape[0]
+        future._cmd.rbuf = &buffer[0] if future._cmd.size > 0 else NULL
+
+    def spiMaster_SingleRead(self, size_t bytesToRead, bint isEndTransaction):
+        """Queue :meth:`FT4222.spiMaster_SingleRead`.
+
+        Returns:
+            :obj:`CommandFuture`: Bytes read from slave
+
+        """
+        cdef CommandFuture future = self._new(_CMD_SPI_READ)
+        self._read(future, bytesToRead)
+        future._cmd.isEnd = isEndTransaction
+        return self._submit(future)
+
+    def spiMaster_SingleRead_into(self, uint8[::1] buffer, bint isEndTransaction):
+        """Queue :meth:`FT4222.spiMaster_SingleRead_into`.
+
+        Returns:
+            :obj:`CommandFuture`: Number of bytes read
+
+        """
+        cdef CommandFuture future = self._new(_CMD_SPI_READ)
+        self._readinto(future, buffer, <size_t>-1)
+        future._cmd.isEnd = isEndTransaction
+        return self._submit(future)
+
+    def spiMaster_SingleWrite(self, data, bint isEndTransaction):
+        """Queue :meth:`FT4222.spiMaster_SingleWrite`.
+
+        Returns:
+            :obj:`CommandFuture`: Number of bytes written
+
+        """
+        cdef CommandFuture future = self._new(_CMD_SPI_WRITE)
+        self._write(future, data, <size_t>-1)
+        future._cmd.isEnd = isEndTransaction
+        return self._submit(future)
+
+    def spiMaster_SingleReadWrite(self, data, bint isEndTransaction):
+        """Queue :meth:`FT4222.spiMaster_SingleReadWrite`.
+
+        Returns:
+            :obj:`CommandFuture`: Bytes read from slave
+
+        """
+        cdef CommandFuture future = self._new(_CMD_SPI_READWRITE)
+        self._write(future, data, <size_t>-1)
+        self._read(future, future._cmd.size)
+        future._cmd.isEnd = isEndTransaction
+        return self._submit(future)
+
+    def spiMaster_SingleReadWrite_into(self, uint8[::1] buffer, data, bint isEndTransaction):
+        """Queue :meth:`FT4222.spiMaster_SingleReadWrite_into`.
+
+        Returns:
+            :obj:`CommandFuture`: Number of bytes transferred
+
+        """
+        cdef CommandFuture future = self._new(_CMD_SPI_READWRITE)
+        self._write(future, data, <size_t>-1)
+        if <size_t>buffer.shape[0] != future._cmd.size:
+            raise ValueError("buffer and data must have the same size")
+        self._readinto(future, buffer, future._cmd.size)
+        future._cmd.isEnd = isEndTransaction
+        return self._submit(future)
+
+    def spiMaster_MultiReadWrite(self, singleWrite, multiWrite, uint16 bytesToRead):
+        """Queue :meth:`FT4222.spiMaster_MultiReadWrite`.
+
+        Returns:
+            :obj:`CommandFuture`: Bytes read from slave in multi-line mode
+
+        """
+        cdef:
+            const uint8[::1] single = _data_view(singleWrite, 'singleWrite')
+            const uint8[::1] multi = _data_view(multiWrite, 'multiWrite')
+            CommandFuture future
+        if single.shape[0] > 15:
+            raise ValueError("singleWrite must not be larger than 15 bytes")
+        if multi.shape[0] > 0xFFFF:
+            raise ValueError("multiWrite must not be larger than 65535 bytes")
+        future = self._new(_CMD_SPI_MULTI)
+        future._scratch = <uint8*>malloc(single.shape[0] + multi.shape[0] + 1)
+        if future._scratch == NULL:
+            raise MemoryError()
+        _concat(future._scratch, single, multi)
+        future._cmd.wbuf = future._scratch
+        future._cmd.singleSize = single.shape[0]
+        future._cmd.value = multi.shape[0]
+        self._read(future, bytesToRead)
+        return self._submit(future)
+
+    def i2cMaster_Read(self, uint16 addr, uint16 bytesToRead):
+        """Queue :meth:`FT4222.i2cMaster_Read`.
+
+        Returns:
+            :obj:`CommandFuture`: Bytes read from slave
+
+        """
+        cdef CommandFuture future = self._new(_CMD_I2C_READ)
+        self._read(future, bytesToRead)
+        future._cmd.addr = addr
+        return self._submit(future)
+
+    def i2cMaster_Read_into(self, uint16 addr, uint8[::1] buffer):
+        """Queue :meth:`FT4222.i2cMaster_Read_into`.
+
+        Returns:
+            :obj:`CommandFuture`: Number of bytes read
+
+        """
+        cdef CommandFuture future = self._new(_CMD_I2C_READ)
+        self._readinto(future, buffer, 0xFFFF)
+        future._cmd.addr = addr
+        return self._submit(future)
+
+    def i2cMaster_Write(self, uint16 addr, data):
+        """Queue :meth:`FT4222.i2cMaster_Write`.
+
+        Returns:
+            :obj:`CommandFuture`: Bytes sent to slave
+
+        """
+        cdef CommandFuture future = self._new(_CMD_I2C_WRITE)
+        self._write(future, data, 0xFFFF)
+        future._cmd.addr = addr
+        return self._submit(future)
+
+    def i2cMaster_ReadEx(self, uint16 addr, uint8 flag, uint16 bytesToRead):
+        """Queue :meth:`FT4222.i2cMaster_ReadEx`.
+
+        Returns:
+            :obj:`CommandFuture`: Bytes read from slave
+
+        """
+        cdef CommandFuture future = self._new(_CMD_I2C_READEX)
+        self._read(future, bytesToRead)
+        future._cmd.addr = addr
+        future._cmd.flag = flag
+        return self._submit(future)
+
+    def i2cMaster_ReadEx_into(self, uint16 addr, uint8 flag, uint8[::1] buffer):
+        """Queue :meth:`FT4222.i2cMaster_ReadEx_into`.
+
+        Returns:
+            :obj:`CommandFuture`: Number of bytes read
+
+        """
+        cdef CommandFuture future = self._new(_CMD_I2C_READEX)
+        self._readinto(future, buffer, 0xFFFF)
+        future._cmd.addr = addr
+        future._cmd.flag = flag
+        return self._submit(future)
+
+    def i2cMaster_WriteEx(self, uint16 addr, uint8 flag, data):
+        """Queue :meth:`FT4222.i2cMaster_WriteEx`.
+
+        Returns:
+            :obj:`CommandFuture`: Bytes sent to slave
+
+        """
+        cdef CommandFuture future = self._new(_CMD_I2C_WRITEEX)
+        self._write(future, data, 0xFFFF)
+        future._cmd.addr = addr
+        future._cmd.flag = flag
+        return self._submit(future)
+
+    def i2cMaster_GetStatus(self):
+        """Queue :meth:`FT4222.i2cMaster_GetStatus`.
+
+        Returns:
+            :obj:`CommandFuture`: Controller status
+
+        """
+        return self._submit(self._new(_CMD_I2C_GETSTATUS))
+
+    def gpio_Read(self, GPIO_Port portNum):
+        """Queue :meth:`FT4222.gpio_Read`.
+
+        Returns:
+            :obj:`CommandFuture`: True if high, False otherwise
+
+        """
+        cdef CommandFuture future = self._new(_CMD_GPIO_READ)
+        future._cmd.addr = portNum
+        return self._submit(future)
+
+    def gpio_Write(self, GPIO_Port portNum, bint value):
+        """Queue :meth:`FT4222.gpio_Write`.
+
+        Returns:
+            :obj:`CommandFuture`: None
+
+        """
+        cdef CommandFuture future = self._new(_CMD_GPIO_WRITE)
+        future._cmd.addr = portNum
+        future._cmd.value = value
+        return self._submit(future)
+
+    def call(self, fn, *args, **kwargs):
+        """Queue fn(*args, **kwargs) to be called from the worker thread.
+
+        Returns:
+            :obj:`CommandFuture`: Return value of fn
+
+        """
+        cdef CommandFuture future = self._new(_CMD_CALL)
+        future._fn = fn
+        future._args = args
+        future._kwargs = kwargs
+        return self._submit(future)
+
+    def __getattr__(self, name):
+        method = getattr(FT4222, name) if not name.startswith('_') else None
+        if method is None or not callable(method):
+            raise AttributeError(name)
+        dev = self._dev
+
+        def queued(*args, **kwargs):
+            return self.call(method, dev, *args, **kwargs)
+        queued.__name__ = queued.__qualname__ = name
+        queued.__doc__ = method.__doc__
+        return queued
+
+    @property
+    def pending(self) -> int:
+        """int: Number of submitted commands not executed yet"""
+        while self._inflight and (<CommandFuture>self._inflight[0]).done():
+            self._inflight.popleft()
+        return len(self._inflight)
+
+    def close(self):
+        """Execute the pending commands and stop the worker thread.
+
+        The device stays open and can be used directly again.
+        """
+        if self._thread is None:
+            return
+        thread, self._thread = self._thread, None
+        _signal_lock(&self._work)
+        _atomic_store_sc(&self._running, 0)
+        _signal_notify(&self._work)
+        _signal_unlock(&self._work)
+        thread.join()
+        self._inflight.clear()
+        self._dev._queued = False
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
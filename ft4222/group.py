@@ -0,0 +1,196 @@
+#  _____ _____ _____
+# |_    |   __| __  |
+# |_| | |__   |    -|
+# |_|_|_|_____|__|__|
+# MSR Electronics GmbH
+# SPDX-License-Identifier: MIT
+#
+
+"""Device groups
+
+Run the same operation on several FT4222 adapters at once.
+
+Every device of a :class:`DeviceGroup` is put into queued mode, so each one gets its own
+worker thread which executes the transfers without the GIL. An operation is submitted to
+all devices before waiting for any of them, the wall time is the one of the slowest
+device instead of the sum of all::
+
+    with DeviceGroup.openBySerial([b'A1', b'A2', b'A3']) as group:
+        group.spiMaster_Init(Mode.SINGLE, Clock.DIV_2, Cpol.IDLE_LOW, Cpha.CLK_LEADING, SlaveSelect.SS0)
+        for r in group.run(lambda dev: SPIFlash(dev).write(0, image)):
+            if r.error is not None:
+                print(r.key, r.error)
+"""
+
+import collections
+
+from . import ft4222 as _ft4222
+
+__all__ = ['DeviceGroup', 'Result']
+
+#: Outcome of an operation on one device of a group, key identifies the device,
+#: error is the exception raised or None, in which case value is the return value
+Result = collections.namedtuple('Result', ['key', 'value', 'error'])
+
+
+class DeviceGroup:
+    """Set of devices operated in parallel.
+
+    All public methods of :class:`ft4222.FT4222` are available with the same arguments,
+    they are executed on all devices and return a :obj:`list` of :obj:`Result` in the
+    order of the devices. Errors don't stop the operation on the other devices. The
+    devices must not be used directly while they belong to the group.
+
+    Args:
+        devices (:obj:`list` of :obj:`ft4222.FT4222`): Opened devices, owned by the group
+        keys (list): Identifier per device used in the results, their index if None
+
+    """
+
+    def __init__(self, devices, keys=None):
+        self.devices = list(devices)
+        self.keys = list(keys) if keys is not None else list(range(len(self.devices)))
+        if len(self.keys) != len(self.devices):
+            raise ValueError("one key per device needed")
+        self._queues = [dev.queue() for dev in self.devices]
+
+    @classmethod
+    def open(cls, devices):
+        """Open a group of devices, all of them concurrently with :func:`ft4222.openMany`.
+
+        Args:
+            devices (list): Serial numbers (bytes, str) and/or location ids (int), used as keys
+
+        Returns:
+            :obj:`DeviceGroup`: Group of the opened devices
+
+        Raises:
+            FT2XXDeviceError: if a device can't be opened, none is left open then
+
+        """
+        keys = list(devices)
+        opened = _ft4222.openMany(keys)
+        errors = [dev for dev in opened if isinstance(dev, Exception)]
+        if errors:
+            for dev in opened:
+                if not isinstance(dev, Exception):
+                    dev.close()
+            raise errors[0]
+        return cls(opened, keys)
+
+    @classmethod
+    def openBySerial(cls, serials):
+        """Open a group of devices by serial number.
+
+        Args:
+            serials (:obj:`list` of :obj:`bytes`): Serial numbers, used as keys
+
+        Returns:
+            :obj:`DeviceGroup`: Group of the opened devices
+
+        Raises:
+            FT2XXDeviceError: if a device can't be opened, none is left open then
+
+        """
+        return cls.open(serials)
+
+    @classmethod
+    def openByLocation(cls, locations):
+        """Open a group of devices by location.
+
+        Args:
+            locations (:obj:`list` of :obj:`int`): Location ids, used as keys
+
+        Returns:
+            :obj:`DeviceGroup`: Group of the opened devices
+
+        Raises:
+            FT2XXDeviceError: if a device can't be opened, none is left open then
+
+        """
+        return cls.open([int(loc) for loc in locations])
+
+    def __len__(self):
+        return len(self.devices)
+
+    def _queued(self):
+        if self._queues is None:
+            raise RuntimeError("device group is closed")
+        return self._queues
+
+    def _collect(self, futures):
+        results = []
+        for key, future in zip(self.keys, futures):
+            try:
+                results.append(Result(key, future.result(), None))
+            except Exception as e:
+                results.append(Result(key, None, e))
+        return results
+
+    def run(self, fn, *args, **kwargs):
+        """Call fn(dev, *args, **kwargs) for every device in its worker thread.
+
+        fn may use the device freely, e.g. a :class:`ft4222.flash.SPIFlash` on it. The
+        library calls it makes release the GIL, so the devices run in parallel.
+
+        Returns:
+            :obj:`list` of :obj:`Result`: Return value or exception per device
+
+        """
+        return self._collect([q.call(fn, dev, *args, **kwargs)
+                              for q, dev in zip(self._queued(), self.devices)])
+
+    def map(self, fn, iterable):
+        """Call fn(dev, item) for every device with its own item of iterable.
+
+        Args:
+            fn (callable): Function to call
+            iterable (iterable): One item per device, e.g. serial numbers to program
+
+        Returns:
+            :obj:`list` of :obj:`Result`: Return value or exception per device
+
+        """
+        items = list(iterable)
+        if len(items) != len(self.devices):
+            raise ValueError("one item per device needed")
+        return self._collect([q.call(fn, dev, item)
+                              for q, dev, item in zip(self._queued(), self.devices, items)])
+
+    def __getattr__(self, name):
+        method = getattr(_ft4222.FT4222, name) if not name.startswith('_') else None
+        if method is None or not callable(method):
+            raise AttributeError(name)
+
+        def call(*args, **kwargs):
+            # transfers known to the command queue run natively, everything else is called
+            return self._collect([getattr(q, name)(*args, **kwargs) for q in self._queued()])
+        call.__name__ = call.__qualname__ = name
+        call.__doc__ = method.__doc__
+        return call
+
+    def close(self):
+        """Wait for the pending operations and close all devices.
+
+        Returns:
+            :obj:`list` of :obj:`Result`: Outcome of closing per device
+
+        """
+        if self._queues is None:
+            return []
+        for q in self._queues:
+            q.close()
+        self._queues = None
+        results = []
+        for key, dev in zip(self.keys, self.devices):
+            try:
+                results.append(Result(key, dev.close(), None))
+            except Exception as e:
+                results.append(Result(key, None, e))
+        return results
+
+    def __enter__(self):
+        return self
+
+    def __exit__(self, *exc):
+        self.close()
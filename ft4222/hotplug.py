@@ -0,0 +1,181 @@
+#  _____ _____ _____
+# |_    |   __| __  |
+# |_| | |__   |    -|
+# |_|_|_|_____|__|__|
+# MSR Electronics GmbH
+# SPDX-License-Identifier: MIT
+#
+
+"""Hotplug
+
+Detect FT4222 adapters being connected or disconnected.
+"""
+
+import logging
+import os
+import queue
+import select
+import socket
+import sys
+import threading
+import time
+
+from . import ft4222 as _ft4222
+
+__all__ = ['DeviceWatcher']
+
+_NETLINK_KOBJECT_UEVENT = 15
+
+_log = logging.getLogger(__name__)
+
+
+def _key(detail):
+    return (detail['serial'], detail['description'], detail['location'])
+
+
+class DeviceWatcher:
+    """Watch for FT4222 adapters being added or removed.
+
+    A background thread waits for USB hotplug events of the kernel (netlink uevents) on
+    Linux, and rebuilds the device list when a device with a matching vendor/product ID
+    comes or goes. If uevents are not available (other systems, restricted containers)
+    the device list is polled instead. Every change is reported as an ``(event, detail)``
+    tuple, event is ``'added'`` or ``'removed'`` and detail has the same shape as the
+    entries of :func:`ft4222.listDevices`, whose snapshot is refreshed as well.
+
+    Changes are passed to callback if given, otherwise they are put into :attr:`queue`::
+
+        with ft4222.DeviceWatcher() as watcher:
+            while True:
+                event, detail = watcher.queue.get()
+                print(event, detail['serial'])
+
+    Args:
+        callback (callable): Called as callback(event, detail) from the watcher thread,
+            exceptions it raises are logged and don't stop the watcher
+        vid (int): USB vendor ID to watch
+        pids (:obj:`list` of :obj:`int`): USB product IDs to watch
+        interval (float): Poll interval in seconds if uevents are not available
+        settle (float): Seconds to wait after a uevent until the device list is rebuilt
+        usePolling (bool): Always poll, even if uevents are available
+
+    """
+
+    def __init__(self, callback=None, vid=0x0403, pids=(0x601c,), interval=1.0, settle=0.05,
+                 usePolling=False):
+        self.callback = callback
+        self.queue = queue.Queue()
+        self._products = {'{:x}/{:x}/'.format(vid, pid) for pid in pids}
+        self.interval = interval
+        self.settle = settle
+        self._usePolling = usePolling
+        self._thread = None
+        self._sock = None
+        self._wakeup = None
+        self._stop = threading.Event()
+        self._devices = {}
+
+    @property
+    def devices(self):
+        """:obj:`list` of :obj:`dict`: Devices known to the watcher"""
+        return list(self._devices.values())
+
+    @property
+    def usesUevents(self):
+        """bool: True if kernel uevents are used, False if the device list is polled"""
+        return self._sock is not None
+
+    def start(self):
+        """Take a snapshot of the connected devices and start watching for changes."""
+        if self._thread is not None:
+            return
+        self._stop.clear()
+        if not self._usePolling and sys.platform.startswith('linux'):
+            try:
+                self._sock = socket.socket(socket.AF_NETLINK, socket.SOCK_DGRAM, _NETLINK_KOBJECT_UEVENT)
+                self._sock.bind((0, 1))
+                self._wakeup = os.pipe()
+            except OSError:
+                self._closeSocket()
+        self._devices = {_key(d): d for d in _ft4222.listDevices(rescan=True)}
+        self._thread = threading.Thread(target=self._run, name='DeviceWatcher', daemon=True)
+        self._thread.start()
+
+    def stop(self):
+        """Stop watching."""
+        if self._thread is None:
+            return
+        self._stop.set()
+        if self._wakeup is not None:
+            os.write(self._wakeup[1], b'\0')
+        self._thread.join()
+        self._thread = None
+        self._closeSocket()
+
+    def __enter__(self):
+        self.start()
+        return self
+
+    def __exit__(self, *exc):
+        self.stop()
+
+    def _closeSocket(self):
+        if self._sock is not None:
+            self._sock.close()
+            self._sock = None
+        if self._wakeup is not None:
+            os.close(self._wakeup[0])
+            os.close(self._wakeup[1])
+            self._wakeup = None
+
+    def _matches(self, uevent):
+        """Check if a raw uevent is about the removal or addition of a watched USB device"""
+        fields = uevent.split(b'\0')
+        env = dict(f.split(b'=', 1) for f in fields[1:] if b'=' in f)
+        if env.get(b'SUBSYSTEM') != b'usb' or env.get(b'DEVTYPE') != b'usb_device':
+            return False
+        if env.get(b'ACTION') not in (b'add', b'remove'):
+            return False
+        product = env.get(b'PRODUCT', b'').decode('ascii', 'replace') + '/'
+        return any(product.startswith(p) for p in self._products)
+
+    def _rescan(self):
+        """Rebuild the device list and report the differences, returns True on changes"""
+        try:
+            devices = {_key(d): d for d in _ft4222.listDevices(rescan=True)}
+        except _ft4222.FT2XXDeviceError:
+            return False
+        changes = [('removed', d) for k, d in self._devices.items() if k not in devices]
+        changes += [('added', d) for k, d in devices.items() if k not in self._devices]
+        self._devices = devices
+        for change in changes:
+            if self.callback is not None:
+                try:
+                    self.callback(*change)
+                except Exception:
+                    _log.exception("hotplug callback failed for %s %r", *change)
+            else:
+                self.queue.put(change)
+        return bool(changes)
+
+    def _run(self):
+        if self._sock is None:
+            while not self._stop.wait(self.interval):
+                self._rescan()
+            return
+
+        sock, wakeup = self._sock, self._wakeup[0]
+        while not self._stop.is_set():
+            readable, _, _ = select.select([sock, wakeup], [], [])
+            if wakeup in readable:
+                break
+            if not self._matches(sock.recv(16384)):
+                continue
+            # the library needs a moment until a new device can be enumerated, retry
+            # until the change shows up, events arriving meanwhile are folded in
+            deadline = time.monotonic() + 1.0
+            while not self._stop.wait(self.settle):
+                while select.select([sock], [], [], 0)[0]:
+                    sock.recv(16384)
+                if self._rescan() or time.monotonic() > deadline:
+                    break
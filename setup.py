@@ -12,6 +12,7 @@ from setuptools.command.build_py import build_py
 from Cython.Build import cythonize
 from sys import platform as os_name
 from platform import system, machine, architecture
+import os
 import shutil
 
 
@@ -60,6 +61,20 @@ else:
     libdirs = [libdir]
     rlibdirs = []
 
+# FT4222_SIM=1 builds the extension against the simulated backend in sim/
+# instead of the vendor library, no hardware is needed to use it.
+sim = os.environ.get("FT4222_SIM", "0") not in ("", "0")
+sources = ["ft4222/ft4222.pyx"]
+if sim:
+    if system() == "Windows":
+        raise Exception("The simulated backend is not supported on Windows")
+    sources.append("sim/ft4222sim.c")
+    libs = ["pthread"]
+    incdirs = ["linux"]
+    libdirs = []
+    rlibdirs = []
+    libs_to_copy = []
+
 class mybuild(build_py):
     def run(self):
         build_py.run(self)
@@ -73,7 +88,7 @@ class mybuild(build_py):
 
 
 extensions = [
-    Extension("ft4222.ft4222", ["ft4222/ft4222.pyx"],
+    Extension("ft4222.ft4222", sources,
         libraries=libs,
         include_dirs=incdirs,
         library_dirs=libdirs,
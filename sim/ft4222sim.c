@@ -0,0 +1,1399 @@
+/*  _____ _____ _____
+ * |_    |   __| __  |
+ * |_| | |__   |    -|
+ * |_|_|_|_____|__|__|
+ * MSR Electronics GmbH
+ * SPDX-License-Identifier: MIT
+ *
+ * Simulated LibFT4222 backend.
+ *
+ * Implements the subset of the libft4222.h / ftd2xx.h API used by the python
+ * wrapper without any hardware attached. Every call is charged a configurable
+ * USB round trip latency plus the time the payload needs at the configured
+ * bandwidth. The following peripherals are attached to every simulated chip:
+ *
+ *  - SPI master: a JEDEC SPI NOR flash with SFDP on SS0
+ *  - SPI slave: an external master streaming an incrementing byte pattern
+ *  - I2C master: a 24C256-style EEPROM at 0x50 and a 256 byte register file
+ *    with auto increment at 0x20
+ *  - I2C slave: an external master sending an incrementing byte pattern
+ *  - GPIO: inputs generate trigger events at a configurable rate
+ *
+ * Configuration is read from the environment on first use:
+ *
+ *  FT4222SIM_DEVICES        number of chips (default 1)
+ *  FT4222SIM_LATENCY_US     latency per USB transaction in us (default 0)
+ *  FT4222SIM_BANDWIDTH      bytes per second on the bus, 0 = unlimited (default 0)
+ *  FT4222SIM_FLASH_SIZE     size of the SPI NOR flash in bytes (default 1 MiB)
+ *  FT4222SIM_FLASH_TPP_US   page program time in us (default 0)
+ *  FT4222SIM_FLASH_TSE_US   sector erase time in us (default 0)
+ *  FT4222SIM_EEPROM_TWR_US  EEPROM write cycle time in us (default 0)
+ *  FT4222SIM_STREAM_RATE    SPI/I2C slave rx rate in bytes per second (default 1000000)
+ *  FT4222SIM_GPIO_RATE      GPIO trigger events per second and port (default 1000)
+ *
+ * Build the python extension against it with ``FT4222_SIM=1 python setup.py build_ext``
+ * or build a drop-in replacement for the vendor library, e.g. on linux:
+ *
+ *  gcc -O2 -shared -fPIC -Ilinux sim/ft4222sim.c -o libft4222.so -lpthread
+ */
+
+#include <stdlib.h>
+#include <stdio.h>
+#include <string.h>
+#include <stdint.h>
+#include <time.h>
+#include <pthread.h>
+#include <errno.h>
+
+#include "libft4222.h"
+
+#define SIM_MAX_DEVICES      64
+#define SIM_FLASH_PAGE       256
+#define SIM_EEPROM_ADDR      0x50
+#define SIM_EEPROM_SIZE      32768
+#define SIM_EEPROM_PAGE      64
+#define SIM_REGFILE_ADDR     0x20
+#define SIM_GPIO_QUEUE       1024
+#define SIM_RX_LIMIT         65535
+
+enum sim_mode { MODE_NONE, MODE_SPI_MASTER, MODE_SPI_SLAVE, MODE_I2C_MASTER, MODE_I2C_SLAVE };
+
+struct sim_config {
+    int devices;
+    uint64_t latency_ns;
+    uint64_t bandwidth;
+    uint32_t flash_size;
+    uint64_t flash_tpp_ns;
+    uint64_t flash_tse_ns;
+    uint64_t eeprom_twr_ns;
+    uint64_t stream_rate;
+    uint64_t gpio_rate;
+};
+
+struct sim_flash {
+    uint8_t *mem;
+    uint32_t size;
+    int wel;
+    uint64_t busy_until;
+    /* current transaction */
+    int active;
+    uint8_t cmd;
+    uint32_t count;
+    uint32_t addr;
+    int addr_bytes;
+    int dummy_bytes;
+    uint8_t page[SIM_FLASH_PAGE];
+    int page_dirty[SIM_FLASH_PAGE];
+    uint32_t page_base;
+};
+
+struct sim_stream {
+    uint64_t start_ns;
+    uint64_t consumed;
+};
+
+struct sim_dev {
+    int index;
+    int open;
+    char serial[16];
+    char description[64];
+    DWORD location;
+    pthread_mutex_t lock;
+
+    enum sim_mode mode;
+    FT4222_ClockRate clock;
+    uint16 max_transfer;
+    FT4222_SPIMode spi_lines;
+    uint8 vendor[256];
+
+    struct sim_flash flash;
+
+    /* I2C master */
+    uint8 i2c_status;
+    uint8_t eeprom[SIM_EEPROM_SIZE];
+    uint16_t eeprom_ptr;
+    uint64_t eeprom_busy_until;
+    uint8_t regfile[256];
+    uint8_t regfile_ptr;
+    /* partial I2C write state between WriteEx calls */
+    int i2c_wr_active;
+    int i2c_held;       /* a START was sent and no STOP yet */
+    uint16 i2c_wr_addr;
+    uint32_t i2c_wr_count;
+
+    /* I2C slave */
+    uint8 i2c_slave_addr;
+
+    struct sim_stream stream;
+
+    /* GPIO */
+    GPIO_Dir gpio_dir[4];
+    BOOL gpio_out[4];
+    GPIO_Trigger gpio_trigger[4];
+    uint64_t gpio_start_ns[4];
+    uint64_t gpio_consumed[4];
+    BOOL gpio_waveform;
+
+    /* USB parameters of the handle */
+    UCHAR latency_timer;
+    ULONG usb_in_size;
+    ULONG usb_out_size;
+    ULONG read_timeout;
+    ULONG write_timeout;
+
+    /* events */
+    DWORD event_mask;
+    EVENT_HANDLE *event;
+    pthread_t event_thread;
+    int event_thread_running;
+};
+
+static struct sim_config cfg;
+static struct sim_dev devs[SIM_MAX_DEVICES];
+static pthread_once_t sim_once = PTHREAD_ONCE_INIT;
+static pthread_mutex_t sim_open_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static uint64_t env_u64(const char *name, uint64_t def)
+{
+    const char *v = getenv(name);
+    if (v == NULL || *v == '\0')
+        return def;
+    return strtoull(v, NULL, 0);
+}
+
+static uint64_t now_ns(void)
+{
+    struct timespec ts;
+    clock_gettime(CLOCK_MONOTONIC, &ts);
+    return (uint64_t)ts.tv_sec * 1000000000ull + (uint64_t)ts.tv_nsec;
+}
+
+static void sleep_ns(uint64_t ns)
+{
+    struct timespec ts;
+    if (ns == 0)
+        return;
+    ts.tv_sec = ns / 1000000000ull;
+    ts.tv_nsec = ns % 1000000000ull;
+    while (nanosleep(&ts, &ts) != 0 && errno == EINTR)
+        ;
+}
+
+static void sim_init(void)
+{
+    int i;
+    cfg.devices = (int)env_u64("FT4222SIM_DEVICES", 1);
+    if (cfg.devices > SIM_MAX_DEVICES)
+        cfg.devices = SIM_MAX_DEVICES;
+    cfg.latency_ns = env_u64("FT4222SIM_LATENCY_US", 0) * 1000ull;
+    cfg.bandwidth = env_u64("FT4222SIM_BANDWIDTH", 0);
+    cfg.flash_size = (uint32_t)env_u64("FT4222SIM_FLASH_SIZE", 1 << 20);
+    cfg.flash_tpp_ns = env_u64("FT4222SIM_FLASH_TPP_US", 0) * 1000ull;
+    cfg.flash_tse_ns = env_u64("FT4222SIM_FLASH_TSE_US", 0) * 1000ull;
+    cfg.eeprom_twr_ns = env_u64("FT4222SIM_EEPROM_TWR_US", 0) * 1000ull;
+    cfg.stream_rate = env_u64("FT4222SIM_STREAM_RATE", 1000000);
+    cfg.gpio_rate = env_u64("FT4222SIM_GPIO_RATE", 1000);
+
+    for (i = 0; i < cfg.devices; i++) {
+        struct sim_dev *d = &devs[i];
+        memset(d, 0, sizeof(*d));
+        d->index = i;
+        snprintf(d->serial, sizeof(d->serial), "SIM%04dA", i);
+        snprintf(d->description, sizeof(d->description), "FT4222 A");
+        d->location = 0x1000 + i;
+        pthread_mutex_init(&d->lock, NULL);
+        d->flash.size = cfg.flash_size;
+        d->flash.mem = malloc(cfg.flash_size);
+        memset(d->flash.mem, 0xFF, cfg.flash_size);
+        memset(d->eeprom, 0xFF, sizeof(d->eeprom));
+        d->i2c_status = 0x20;
+        d->i2c_slave_addr = 0x40;
+        d->clock = SYS_CLK_60;
+        d->max_transfer = 512;
+    }
+}
+
+static struct sim_dev *sim_get(FT_HANDLE h)
+{
+    struct sim_dev *d = (struct sim_dev *)h;
+    pthread_once(&sim_once, sim_init);
+    if (d < devs || d >= devs + cfg.devices || !d->open)
+        return NULL;
+    return d;
+}
+
+/* Charge one USB transaction moving nbytes over the bus. */
+static void sim_usb(uint64_t nbytes)
+{
+    uint64_t t = cfg.latency_ns;
+    if (cfg.bandwidth)
+        t += nbytes * 1000000000ull / cfg.bandwidth;
+    sleep_ns(t);
+}
+
+#define SIM_DEV(h) \
+    struct sim_dev *d = sim_get(h); \
+    if (d == NULL) return FT4222_INVALID_HANDLE;
+
+/* ---------------------------------------------------------------------------
+ * ftd2xx
+ */
+
+FT_STATUS WINAPI FT_CreateDeviceInfoList(LPDWORD lpdwNumDevs)
+{
+    pthread_once(&sim_once, sim_init);
+    if (lpdwNumDevs == NULL)
+        return FT_INVALID_PARAMETER;
+    sim_usb(0);
+    *lpdwNumDevs = cfg.devices;
+    return FT_OK;
+}
+
+FT_STATUS WINAPI FT_GetDeviceInfoList(FT_DEVICE_LIST_INFO_NODE *pDest, LPDWORD lpdwNumDevs)
+{
+    int i;
+    pthread_once(&sim_once, sim_init);
+    if (pDest == NULL || lpdwNumDevs == NULL)
+        return FT_INVALID_PARAMETER;
+    for (i = 0; i < cfg.devices; i++) {
+        struct sim_dev *d = &devs[i];
+        memset(&pDest[i], 0, sizeof(pDest[i]));
+        pDest[i].Flags = (d->open ? FT_FLAGS_OPENED : 0) | FT_FLAGS_HISPEED;
+        pDest[i].Type = FT_DEVICE_4222H_0;
+        pDest[i].ID = 0x0403601c;
+        pDest[i].LocId = d->location;
+        strcpy(pDest[i].SerialNumber, d->serial);
+        strcpy(pDest[i].Description, d->description);
+        pDest[i].ftHandle = d->open ? (FT_HANDLE)d : NULL;
+    }
+    *lpdwNumDevs = cfg.devices;
+    return FT_OK;
+}
+
+FT_STATUS WINAPI FT_GetDeviceInfoDetail(DWORD dwIndex, LPDWORD lpdwFlags, LPDWORD lpdwType,
+    LPDWORD lpdwID, LPDWORD lpdwLocId, LPVOID lpSerialNumber, LPVOID lpDescription,
+    FT_HANDLE *pftHandle)
+{
+    struct sim_dev *d;
+    pthread_once(&sim_once, sim_init);
+    if ((int)dwIndex >= cfg.devices)
+        return FT_DEVICE_NOT_FOUND;
+    d = &devs[dwIndex];
+    if (lpdwFlags) *lpdwFlags = (d->open ? FT_FLAGS_OPENED : 0) | FT_FLAGS_HISPEED;
+    if (lpdwType) *lpdwType = FT_DEVICE_4222H_0;
+    if (lpdwID) *lpdwID = 0x0403601c;
+    if (lpdwLocId) *lpdwLocId = d->location;
+    if (lpSerialNumber) strcpy((char *)lpSerialNumber, d->serial);
+    if (lpDescription) strcpy((char *)lpDescription, d->description);
+    if (pftHandle) *pftHandle = d->open ? (FT_HANDLE)d : NULL;
+    return FT_OK;
+}
+
+FT_STATUS WINAPI FT_OpenEx(PVOID pArg1, DWORD Flags, FT_HANDLE *pHandle)
+{
+    int i;
+    pthread_once(&sim_once, sim_init);
+    if (pHandle == NULL)
+        return FT_INVALID_PARAMETER;
+    sim_usb(0);
+    pthread_mutex_lock(&sim_open_lock);
+    for (i = 0; i < cfg.devices; i++) {
+        struct sim_dev *d = &devs[i];
+        int match = 0;
+        if (Flags == FT_OPEN_BY_SERIAL_NUMBER)
+            match = strcmp((const char *)pArg1, d->serial) == 0;
+        else if (Flags == FT_OPEN_BY_DESCRIPTION)
+            match = strcmp((const char *)pArg1, d->description) == 0;
+        else if (Flags == FT_OPEN_BY_LOCATION)
+            match = (DWORD)(uintptr_t)pArg1 == d->location;
+        if (match && !d->open) {
+            d->open = 1;
+            d->mode = MODE_NONE;
+            d->latency_timer = 16;
+            d->usb_in_size = d->usb_out_size = 4096;
+            d->read_timeout = d->write_timeout = 0;
+            *pHandle = (FT_HANDLE)d;
+            pthread_mutex_unlock(&sim_open_lock);
+            return FT_OK;
+        }
+    }
+    pthread_mutex_unlock(&sim_open_lock);
+    return FT_DEVICE_NOT_FOUND;
+}
+
+static void sim_event_stop(struct sim_dev *d);
+
+FT_STATUS WINAPI FT_Close(FT_HANDLE ftHandle)
+{
+    struct sim_dev *d = sim_get(ftHandle);
+    if (d == NULL)
+        return FT_INVALID_HANDLE;
+    sim_event_stop(d);
+    pthread_mutex_lock(&sim_open_lock);
+    d->open = 0;
+    pthread_mutex_unlock(&sim_open_lock);
+    return FT_OK;
+}
+
+static void flash_end(struct sim_dev *d);
+
+FT_STATUS WINAPI FT_Write(FT_HANDLE ftHandle, LPVOID lpBuffer, DWORD dwBytesToWrite,
+    LPDWORD lpBytesWritten)
+{
+    struct sim_dev *d = sim_get(ftHandle);
+    (void)lpBuffer;
+    if (d == NULL)
+        return FT_INVALID_HANDLE;
+    sim_usb(dwBytesToWrite);
+    pthread_mutex_lock(&d->lock);
+    if (d->mode == MODE_SPI_MASTER)
+        flash_end(d);
+    pthread_mutex_unlock(&d->lock);
+    if (lpBytesWritten)
+        *lpBytesWritten = dwBytesToWrite;
+    return FT_OK;
+}
+
+FT_STATUS WINAPI FT_VendorCmdGet(FT_HANDLE ftHandle, UCHAR Request, UCHAR *Buf, USHORT Len)
+{
+    struct sim_dev *d = sim_get(ftHandle);
+    if (d == NULL)
+        return FT_INVALID_HANDLE;
+    sim_usb(Len);
+    memset(Buf, d->vendor[Request], Len);
+    return FT_OK;
+}
+
+FT_STATUS WINAPI FT_VendorCmdSet(FT_HANDLE ftHandle, UCHAR Request, UCHAR *Buf, USHORT Len)
+{
+    struct sim_dev *d = sim_get(ftHandle);
+    if (d == NULL)
+        return FT_INVALID_HANDLE;
+    sim_usb(Len);
+    if (Len > 0)
+        d->vendor[Request] = Buf[0];
+    return FT_OK;
+}
+
+FT_STATUS WINAPI FT_SetTimeouts(FT_HANDLE ftHandle, ULONG ReadTimeout, ULONG WriteTimeout)
+{
+    struct sim_dev *d = sim_get(ftHandle);
+    if (d == NULL)
+        return FT_INVALID_HANDLE;
+    d->read_timeout = ReadTimeout;
+    d->write_timeout = WriteTimeout;
+    return FT_OK;
+}
+
+FT_STATUS WINAPI FT_SetLatencyTimer(FT_HANDLE ftHandle, UCHAR ucLatency)
+{
+    struct sim_dev *d = sim_get(ftHandle);
+    if (d == NULL)
+        return FT_INVALID_HANDLE;
+    if (ucLatency < 2)
+        return FT_INVALID_PARAMETER;
+    sim_usb(0);
+    d->latency_timer = ucLatency;
+    return FT_OK;
+}
+
+FT_STATUS WINAPI FT_GetLatencyTimer(FT_HANDLE ftHandle, PUCHAR pucLatency)
+{
+    struct sim_dev *d = sim_get(ftHandle);
+    if (d == NULL)
+        return FT_INVALID_HANDLE;
+    if (pucLatency == NULL)
+        return FT_INVALID_PARAMETER;
+    sim_usb(0);
+    *pucLatency = d->latency_timer;
+    return FT_OK;
+}
+
+FT_STATUS WINAPI FT_SetUSBParameters(FT_HANDLE ftHandle, ULONG ulInTransferSize, ULONG ulOutTransferSize)
+{
+    struct sim_dev *d = sim_get(ftHandle);
+    if (d == NULL)
+        return FT_INVALID_HANDLE;
+    /* multiples of 64 bytes between 64 bytes and 64 kB, 0 keeps the current size */
+    if ((ulInTransferSize % 64) || ulInTransferSize > 65536 ||
+        (ulOutTransferSize % 64) || ulOutTransferSize > 65536)
+        return FT_INVALID_PARAMETER;
+    if (ulInTransferSize)
+        d->usb_in_size = ulInTransferSize;
+    if (ulOutTransferSize)
+        d->usb_out_size = ulOutTransferSize;
+    return FT_OK;
+}
+
+FT_STATUS WINAPI FT_Purge(FT_HANDLE ftHandle, ULONG Mask)
+{
+    struct sim_dev *d = sim_get(ftHandle);
+    if (d == NULL)
+        return FT_INVALID_HANDLE;
+    if (Mask & ~(ULONG)(FT_PURGE_RX | FT_PURGE_TX))
+        return FT_INVALID_PARAMETER;
+    sim_usb(0);
+    return FT_OK;
+}
+
+/* ---------------------------------------------------------------------------
+ * general
+ */
+
+FT4222_STATUS FT4222_UnInitialize(FT_HANDLE ftHandle)
+{
+    SIM_DEV(ftHandle);
+    sim_event_stop(d);
+    d->mode = MODE_NONE;
+    return FT4222_OK;
+}
+
+FT4222_STATUS FT4222_SetClock(FT_HANDLE ftHandle, FT4222_ClockRate clk)
+{
+    SIM_DEV(ftHandle);
+    if (clk > SYS_CLK_80)
+        return FT4222_INVALID_PARAMETER;
+    sim_usb(0);
+    d->clock = clk;
+    return FT4222_OK;
+}
+
+FT4222_STATUS FT4222_GetClock(FT_HANDLE ftHandle, FT4222_ClockRate *clk)
+{
+    SIM_DEV(ftHandle);
+    sim_usb(0);
+    *clk = d->clock;
+    return FT4222_OK;
+}
+
+FT4222_STATUS FT4222_SetWakeUpInterrupt(FT_HANDLE ftHandle, BOOL enable)
+{
+    SIM_DEV(ftHandle);
+    (void)enable;
+    sim_usb(0);
+    return FT4222_OK;
+}
+
+FT4222_STATUS FT4222_SetInterruptTrigger(FT_HANDLE ftHandle, GPIO_Trigger trigger)
+{
+    SIM_DEV(ftHandle);
+    (void)trigger;
+    sim_usb(0);
+    return FT4222_OK;
+}
+
+FT4222_STATUS FT4222_SetSuspendOut(FT_HANDLE ftHandle, BOOL enable)
+{
+    SIM_DEV(ftHandle);
+    (void)enable;
+    sim_usb(0);
+    return FT4222_OK;
+}
+
+FT4222_STATUS FT4222_GetMaxTransferSize(FT_HANDLE ftHandle, uint16 *pMaxSize)
+{
+    SIM_DEV(ftHandle);
+    if (d->mode == MODE_NONE)
+        return FT4222_INVAILD_FUNCTION;
+    *pMaxSize = d->max_transfer;
+    return FT4222_OK;
+}
+
+FT4222_STATUS FT4222_GetVersion(FT_HANDLE ftHandle, FT4222_Version *pVersion)
+{
+    SIM_DEV(ftHandle);
+    sim_usb(0);
+    pVersion->chipVersion = 0x42220300;
+    pVersion->dllVersion = 0x01040444;
+    return FT4222_OK;
+}
+
+FT4222_STATUS FT4222_ChipReset(FT_HANDLE ftHandle)
+{
+    SIM_DEV(ftHandle);
+    sim_usb(0);
+    d->mode = MODE_NONE;
+    return FT4222_OK;
+}
+
+/* ---------------------------------------------------------------------------
+ * streaming rx sources (SPI slave, I2C slave)
+ */
+
+static uint64_t stream_available(struct sim_dev *d)
+{
+    uint64_t produced = (now_ns() - d->stream.start_ns) * cfg.stream_rate / 1000000000ull;
+    uint64_t avail = produced - d->stream.consumed;
+    if (avail > SIM_RX_LIMIT) {
+        /* the chip's fifo overflowed, older data is lost */
+        d->stream.consumed = produced - SIM_RX_LIMIT;
+        avail = SIM_RX_LIMIT;
+    }
+    return avail;
+}
+
+static uint16 stream_read(struct sim_dev *d, uint8 *buffer, uint16 size)
+{
+    uint64_t avail = stream_available(d);
+    uint16 n = size < avail ? size : (uint16)avail;
+    uint16 i;
+    for (i = 0; i < n; i++)
+        buffer[i] = (uint8)(d->stream.consumed + i);
+    d->stream.consumed += n;
+    return n;
+}
+
+static void stream_start(struct sim_dev *d)
+{
+    d->stream.start_ns = now_ns();
+    d->stream.consumed = 0;
+}
+
+/* ---------------------------------------------------------------------------
+ * GPIO
+ */
+
+static uint64_t gpio_pending(struct sim_dev *d, int port)
+{
+    uint64_t produced, pending;
+    if (d->gpio_dir[port] != GPIO_INPUT || d->gpio_trigger[port] == 0)
+        return 0;
+    produced = (now_ns() - d->gpio_start_ns[port]) * cfg.gpio_rate / 1000000000ull;
+    pending = produced - d->gpio_consumed[port];
+    if (pending > SIM_GPIO_QUEUE) {
+        d->gpio_consumed[port] = produced - SIM_GPIO_QUEUE;
+        pending = SIM_GPIO_QUEUE;
+    }
+    return pending;
+}
+
+/* The n-th event of a port alternates between the enabled edge triggers. */
+static GPIO_Trigger gpio_event(struct sim_dev *d, int port, uint64_t n)
+{
+    GPIO_Trigger t = d->gpio_trigger[port];
+    if ((t & GPIO_TRIGGER_RISING) && (t & GPIO_TRIGGER_FALLING))
+        return (n & 1) ? GPIO_TRIGGER_FALLING : GPIO_TRIGGER_RISING;
+    if (t & GPIO_TRIGGER_RISING)
+        return GPIO_TRIGGER_RISING;
+    if (t & GPIO_TRIGGER_FALLING)
+        return GPIO_TRIGGER_FALLING;
+    if (t & GPIO_TRIGGER_LEVEL_HIGH)
+        return GPIO_TRIGGER_LEVEL_HIGH;
+    return GPIO_TRIGGER_LEVEL_LOW;
+}
+
+FT4222_STATUS FT4222_GPIO_Init(FT_HANDLE ftHandle, GPIO_Dir gpioDir[4])
+{
+    int i;
+    SIM_DEV(ftHandle);
+    sim_usb(0);
+    for (i = 0; i < 4; i++) {
+        d->gpio_dir[i] = gpioDir[i];
+        d->gpio_out[i] = 0;
+        d->gpio_trigger[i] = 0;
+    }
+    return FT4222_OK;
+}
+
+FT4222_STATUS FT4222_GPIO_Read(FT_HANDLE ftHandle, GPIO_Port portNum, BOOL *value)
+{
+    SIM_DEV(ftHandle);
+    if (portNum > GPIO_PORT3)
+        return FT4222_GPIO_EXCEEDED_MAX_PORTNUM;
+    sim_usb(1);
+    if (d->gpio_dir[portNum] == GPIO_OUTPUT)
+        *value = d->gpio_out[portNum];
+    else
+        *value = (now_ns() / 1000000ull) & 1;
+    return FT4222_OK;
+}
+
+FT4222_STATUS FT4222_GPIO_Write(FT_HANDLE ftHandle, GPIO_Port portNum, BOOL bValue)
+{
+    SIM_DEV(ftHandle);
+    if (portNum > GPIO_PORT3)
+        return FT4222_GPIO_EXCEEDED_MAX_PORTNUM;
+    if (d->gpio_dir[portNum] != GPIO_OUTPUT)
+        return FT4222_GPIO_WRITE_NOT_SUPPORTED;
+    sim_usb(1);
+    d->gpio_out[portNum] = bValue ? 1 : 0;
+    return FT4222_OK;
+}
+
+FT4222_STATUS FT4222_GPIO_SetInputTrigger(FT_HANDLE ftHandle, GPIO_Port portNum, GPIO_Trigger trigger)
+{
+    SIM_DEV(ftHandle);
+    if (portNum > GPIO_PORT3)
+        return FT4222_GPIO_EXCEEDED_MAX_PORTNUM;
+    if (d->gpio_dir[portNum] != GPIO_INPUT)
+        return FT4222_GPIO_INPUT_NOT_SUPPORTED;
+    sim_usb(0);
+    pthread_mutex_lock(&d->lock);
+    d->gpio_trigger[portNum] = trigger;
+    d->gpio_start_ns[portNum] = now_ns();
+    d->gpio_consumed[portNum] = 0;
+    pthread_mutex_unlock(&d->lock);
+    return FT4222_OK;
+}
+
+FT4222_STATUS FT4222_GPIO_GetTriggerStatus(FT_HANDLE ftHandle, GPIO_Port portNum, uint16 *queueSize)
+{
+    SIM_DEV(ftHandle);
+    if (portNum > GPIO_PORT3)
+        return FT4222_GPIO_EXCEEDED_MAX_PORTNUM;
+    sim_usb(2);
+    pthread_mutex_lock(&d->lock);
+    *queueSize = (uint16)gpio_pending(d, portNum);
+    pthread_mutex_unlock(&d->lock);
+    return FT4222_OK;
+}
+
+FT4222_STATUS FT4222_GPIO_ReadTriggerQueue(FT_HANDLE ftHandle, GPIO_Port portNum,
+    GPIO_Trigger *events, uint16 readSize, uint16 *sizeofRead)
+{
+    uint64_t pending, i;
+    SIM_DEV(ftHandle);
+    if (portNum > GPIO_PORT3)
+        return FT4222_GPIO_EXCEEDED_MAX_PORTNUM;
+    if (events == NULL || sizeofRead == NULL)
+        return FT4222_INVALID_POINTER;
+    pthread_mutex_lock(&d->lock);
+    pending = gpio_pending(d, portNum);
+    if (pending > readSize)
+        pending = readSize;
+    for (i = 0; i < pending; i++)
+        events[i] = gpio_event(d, portNum, d->gpio_consumed[portNum] + i);
+    d->gpio_consumed[portNum] += pending;
+    pthread_mutex_unlock(&d->lock);
+    *sizeofRead = (uint16)pending;
+    sim_usb(pending * sizeof(GPIO_Trigger));
+    return FT4222_OK;
+}
+
+FT4222_STATUS FT4222_GPIO_SetWaveFormMode(FT_HANDLE ftHandle, BOOL enable)
+{
+    SIM_DEV(ftHandle);
+    sim_usb(0);
+    d->gpio_waveform = enable ? 1 : 0;
+    return FT4222_OK;
+}
+
+/* ---------------------------------------------------------------------------
+ * SPI NOR flash on SS0
+ */
+
+/* Serial Flash Discoverable Parameters: header, one parameter header and a
+ * JESD216 basic flash parameter table (9 DWORDs). */
+static void flash_sfdp(struct sim_flash *f, uint8_t *sfdp, size_t len)
+{
+    uint32_t bfpt[9];
+    uint32_t density = f->size * 8 - 1;
+    int i;
+
+    memset(sfdp, 0xFF, len);
+    sfdp[0] = 'S'; sfdp[1] = 'F'; sfdp[2] = 'D'; sfdp[3] = 'P';
+    sfdp[4] = 0x00; sfdp[5] = 0x01; /* rev 1.0 */
+    sfdp[6] = 0x00;                 /* one parameter header */
+    sfdp[7] = 0xFF;
+    /* parameter header 0: JEDEC basic table, 9 DWORDs at 0x30 */
+    sfdp[8] = 0x00; sfdp[9] = 0x00; sfdp[10] = 0x01; sfdp[11] = 9;
+    sfdp[12] = 0x30; sfdp[13] = 0x00; sfdp[14] = 0x00; sfdp[15] = 0xFF;
+
+    memset(bfpt, 0xFF, sizeof(bfpt));
+    /* 4K erase supported, opcode 0x20, 3-byte addressing, 1-1-2 fast read */
+    bfpt[0] = 0xFF000000u | (0x20u << 8) | (1u << 16) | (0u << 17) | 0x01u | (1u << 22);
+    bfpt[1] = density;
+    /* 1-1-4 fast read: 8 dummy clocks, opcode 0x6B */
+    bfpt[2] = (0x6Bu << 24) | (8u << 16) | 0xFFFFu;
+    /* 1-1-2 fast read: 8 dummy clocks, opcode 0x3B */
+    bfpt[3] = (0x3Bu << 8) | 8u | 0xFFFF0000u;
+    bfpt[4] = 0xFFFFFFEEu;
+    bfpt[5] = 0xFFFFFFFFu;
+    bfpt[6] = 0xFFFFFFFFu;
+    /* erase types: 4K/0x20, 64K/0xD8 */
+    bfpt[7] = (0xD8u << 24) | (16u << 16) | (0x20u << 8) | 12u;
+    bfpt[8] = 0x00000000u;
+    for (i = 0; i < 9; i++) {
+        size_t o = 0x30 + i * 4;
+        if (o + 4 > len)
+            break;
+        sfdp[o] = bfpt[i] & 0xFF;
+        sfdp[o + 1] = (bfpt[i] >> 8) & 0xFF;
+        sfdp[o + 2] = (bfpt[i] >> 16) & 0xFF;
+        sfdp[o + 3] = (bfpt[i] >> 24) & 0xFF;
+    }
+}
+
+static int flash_busy(struct sim_flash *f)
+{
+    return now_ns() < f->busy_until;
+}
+
+/* Clock one byte through the flash; returns the byte shifted out. */
+static uint8_t flash_byte(struct sim_flash *f, uint8_t in)
+{
+    uint32_t n = f->count++;
+    uint8_t sfdp[0x60];
+
+    if (n == 0) {
+        f->cmd = in;
+        f->addr = 0;
+        f->addr_bytes = 0;
+        f->dummy_bytes = 0;
+        switch (in) {
+        case 0x03: f->addr_bytes = 3; break;
+        case 0x0B: case 0x3B: case 0x6B: case 0x5A: f->addr_bytes = 3; f->dummy_bytes = 1; break;
+        case 0x02: case 0x20: case 0xD8: f->addr_bytes = 3; break;
+        case 0x06: if (!flash_busy(f)) f->wel = 1; break;
+        case 0x04: if (!flash_busy(f)) f->wel = 0; break;
+        }
+        if (in == 0x02) {
+            memset(f->page_dirty, 0, sizeof(f->page_dirty));
+        }
+        return 0xFF;
+    }
+    if (n <= (uint32_t)f->addr_bytes) {
+        f->addr = (f->addr << 8) | in;
+        if (f->cmd == 0x02 && n == (uint32_t)f->addr_bytes)
+            f->page_base = f->addr & ~(uint32_t)(SIM_FLASH_PAGE - 1);
+        return 0xFF;
+    }
+    if (n <= (uint32_t)(f->addr_bytes + f->dummy_bytes))
+        return 0xFF;
+
+    n -= 1 + f->addr_bytes + f->dummy_bytes;
+    switch (f->cmd) {
+    case 0x9F: {
+        static const uint8_t id[3] = { 0xEF, 0x40, 0x14 };
+        return n < 3 ? id[n] : 0xFF;
+    }
+    case 0x05:
+        return (flash_busy(f) ? 0x01 : 0x00) | (f->wel ? 0x02 : 0x00);
+    case 0x03: case 0x0B: case 0x3B: case 0x6B:
+        if (flash_busy(f))
+            return 0xFF;
+        return f->mem[(f->addr + n) % f->size];
+    case 0x5A:
+        flash_sfdp(f, sfdp, sizeof(sfdp));
+        return (f->addr + n) < sizeof(sfdp) ? sfdp[f->addr + n] : 0xFF;
+    case 0x02: {
+        uint32_t o = ((f->addr & (SIM_FLASH_PAGE - 1)) + n) % SIM_FLASH_PAGE;
+        f->page[o] = in;
+        f->page_dirty[o] = 1;
+        return 0xFF;
+    }
+    }
+    return 0xFF;
+}
+
+/* CS deasserted: execute program and erase commands. */
+static void flash_end(struct sim_dev *d)
+{
+    struct sim_flash *f = &d->flash;
+    uint32_t i, base;
+
+    if (!f->active)
+        return;
+    f->active = 0;
+    if (flash_busy(f) || !f->wel)
+        goto done;
+    switch (f->cmd) {
+    case 0x02:
+        if (f->count < 5)
+            break;
+        base = f->page_base % f->size;
+        for (i = 0; i < SIM_FLASH_PAGE; i++)
+            if (f->page_dirty[i])
+                f->mem[base + i] &= f->page[i];
+        f->wel = 0;
+        f->busy_until = now_ns() + cfg.flash_tpp_ns;
+        break;
+    case 0x20:
+    case 0xD8:
+        if (f->count != 4)
+            break;
+        i = f->cmd == 0x20 ? 4096 : 65536;
+        base = (f->addr & ~(i - 1)) % f->size;
+        memset(f->mem + base, 0xFF, i);
+        f->wel = 0;
+        f->busy_until = now_ns() + cfg.flash_tse_ns;
+        break;
+    case 0xC7:
+    case 0x60:
+        memset(f->mem, 0xFF, f->size);
+        f->wel = 0;
+        f->busy_until = now_ns() + cfg.flash_tse_ns * 16;
+        break;
+    }
+done:
+    f->count = 0;
+}
+
+static void flash_xfer(struct sim_dev *d, uint8 *rx, const uint8 *tx, uint32_t n)
+{
+    struct sim_flash *f = &d->flash;
+    uint32_t i;
+    if (!f->active) {
+        f->active = 1;
+        f->count = 0;
+    }
+    for (i = 0; i < n; i++) {
+        uint8_t o = flash_byte(f, tx ? tx[i] : 0xFF);
+        if (rx)
+            rx[i] = o;
+    }
+}
+
+/* ---------------------------------------------------------------------------
+ * SPI
+ */
+
+FT4222_STATUS FT4222_SPI_Reset(FT_HANDLE ftHandle)
+{
+    SIM_DEV(ftHandle);
+    sim_usb(0);
+    d->flash.active = 0;
+    d->flash.count = 0;
+    return FT4222_OK;
+}
+
+FT4222_STATUS FT4222_SPI_ResetTransaction(FT_HANDLE ftHandle, uint8 spiIdx)
+{
+    SIM_DEV(ftHandle);
+    if (spiIdx > 3)
+        return FT4222_INVALID_PARAMETER;
+    sim_usb(0);
+    return FT4222_OK;
+}
+
+FT4222_STATUS FT4222_SPI_SetDrivingStrength(FT_HANDLE ftHandle, SPI_DrivingStrength clkStrength,
+    SPI_DrivingStrength ioStrength, SPI_DrivingStrength ssoStrength)
+{
+    SIM_DEV(ftHandle);
+    (void)clkStrength; (void)ioStrength; (void)ssoStrength;
+    sim_usb(0);
+    return FT4222_OK;
+}
+
+FT4222_STATUS FT4222_SPIMaster_Init(FT_HANDLE ftHandle, FT4222_SPIMode ioLine, FT4222_SPIClock clock,
+    FT4222_SPICPOL cpol, FT4222_SPICPHA cpha, uint8 ssoMap)
+{
+    SIM_DEV(ftHandle);
+    (void)cpol; (void)cpha;
+    if (clock == CLK_NONE || clock > CLK_DIV_512 || ssoMap == 0)
+        return FT4222_INVALID_PARAMETER;
+    if (ioLine != SPI_IO_SINGLE && ioLine != SPI_IO_DUAL && ioLine != SPI_IO_QUAD)
+        return FT4222_INVALID_PARAMETER;
+    sim_usb(0);
+    d->mode = MODE_SPI_MASTER;
+    d->spi_lines = ioLine;
+    d->max_transfer = 512;
+    d->flash.active = 0;
+    d->flash.count = 0;
+    return FT4222_OK;
+}
+
+FT4222_STATUS FT4222_SPIMaster_SetCS(FT_HANDLE ftHandle, SPI_ChipSelect cs)
+{
+    SIM_DEV(ftHandle);
+    (void)cs;
+    return FT4222_OK;
+}
+
+FT4222_STATUS FT4222_SPIMaster_SetLines(FT_HANDLE ftHandle, FT4222_SPIMode spiMode)
+{
+    SIM_DEV(ftHandle);
+    if (d->mode != MODE_SPI_MASTER)
+        return FT4222_IS_NOT_SPI_MODE;
+    if (spiMode != SPI_IO_SINGLE && spiMode != SPI_IO_DUAL && spiMode != SPI_IO_QUAD)
+        return FT4222_INVALID_PARAMETER;
+    sim_usb(0);
+    d->spi_lines = spiMode;
+    return FT4222_OK;
+}
+
+static FT4222_STATUS spi_single(struct sim_dev *d, uint8 *rx, const uint8 *tx, uint16 size,
+    uint16 *transferred, BOOL isEndTransaction)
+{
+    if (d->mode != MODE_SPI_MASTER)
+        return FT4222_IS_NOT_SPI_MODE;
+    if (d->spi_lines != SPI_IO_SINGLE)
+        return FT4222_IS_NOT_SPI_SINGLE_MODE;
+    if (transferred == NULL || (size > 0 && rx == NULL && tx == NULL))
+        return FT4222_INVALID_POINTER;
+    sim_usb(size);
+    pthread_mutex_lock(&d->lock);
+    flash_xfer(d, rx, tx, size);
+    if (isEndTransaction)
+        flash_end(d);
+    pthread_mutex_unlock(&d->lock);
+    *transferred = size;
+    return FT4222_OK;
+}
+
+FT4222_STATUS FT4222_SPIMaster_SingleRead(FT_HANDLE ftHandle, uint8 *buffer, uint16 bufferSize,
+    uint16 *sizeOfRead, BOOL isEndTransaction)
+{
+    SIM_DEV(ftHandle);
+    if (buffer == NULL && bufferSize > 0)
+        return FT4222_INVALID_POINTER;
+    return spi_single(d, buffer, NULL, bufferSize, sizeOfRead, isEndTransaction);
+}
+
+FT4222_STATUS FT4222_SPIMaster_SingleWrite(FT_HANDLE ftHandle, uint8 *buffer, uint16 bufferSize,
+    uint16 *sizeTransferred, BOOL isEndTransaction)
+{
+    SIM_DEV(ftHandle);
+    if (buffer == NULL && bufferSize > 0)
+        return FT4222_INVALID_POINTER;
+    return spi_single(d, NULL, buffer, bufferSize, sizeTransferred, isEndTransaction);
+}
+
+FT4222_STATUS FT4222_SPIMaster_SingleReadWrite(FT_HANDLE ftHandle, uint8 *readBuffer,
+    uint8 *writeBuffer, uint16 bufferSize, uint16 *sizeTransferred, BOOL isEndTransaction)
+{
+    SIM_DEV(ftHandle);
+    if ((readBuffer == NULL || writeBuffer == NULL) && bufferSize > 0)
+        return FT4222_INVALID_POINTER;
+    return spi_single(d, readBuffer, writeBuffer, bufferSize, sizeTransferred, isEndTransaction);
+}
+
+FT4222_STATUS FT4222_SPIMaster_MultiReadWrite(FT_HANDLE ftHandle, uint8 *readBuffer,
+    uint8 *writeBuffer, uint8 singleWriteBytes, uint16 multiWriteBytes, uint16 multiReadBytes,
+    uint32 *sizeOfRead)
+{
+    SIM_DEV(ftHandle);
+    if (d->mode != MODE_SPI_MASTER)
+        return FT4222_IS_NOT_SPI_MODE;
+    if (d->spi_lines == SPI_IO_SINGLE)
+        return FT4222_IS_NOT_SPI_MULTI_MODE;
+    if (singleWriteBytes > 15 || sizeOfRead == NULL)
+        return FT4222_INVALID_PARAMETER;
+    if ((readBuffer == NULL && multiReadBytes > 0) ||
+        (writeBuffer == NULL && (singleWriteBytes + multiWriteBytes) > 0))
+        return FT4222_INVALID_POINTER;
+    sim_usb((uint64_t)singleWriteBytes + multiWriteBytes + multiReadBytes);
+    pthread_mutex_lock(&d->lock);
+    flash_xfer(d, NULL, writeBuffer, singleWriteBytes + multiWriteBytes);
+    flash_xfer(d, readBuffer, NULL, multiReadBytes);
+    flash_end(d);
+    pthread_mutex_unlock(&d->lock);
+    *sizeOfRead = multiReadBytes;
+    return FT4222_OK;
+}
+
+FT4222_STATUS FT4222_SPISlave_Init(FT_HANDLE ftHandle)
+{
+    SIM_DEV(ftHandle);
+    sim_usb(0);
+    d->mode = MODE_SPI_SLAVE;
+    d->max_transfer = 64;
+    stream_start(d);
+    return FT4222_OK;
+}
+
+FT4222_STATUS FT4222_SPISlave_InitEx(FT_HANDLE ftHandle, SPI_SlaveProtocol protocolOpt)
+{
+    if (protocolOpt > SPI_SLAVE_NO_ACK)
+        return FT4222_INVALID_PARAMETER;
+    return FT4222_SPISlave_Init(ftHandle);
+}
+
+FT4222_STATUS FT4222_SPISlave_SetMode(FT_HANDLE ftHandle, FT4222_SPICPOL cpol, FT4222_SPICPHA cpha)
+{
+    SIM_DEV(ftHandle);
+    (void)cpol; (void)cpha;
+    if (d->mode != MODE_SPI_SLAVE)
+        return FT4222_IS_NOT_SPI_MODE;
+    sim_usb(0);
+    return FT4222_OK;
+}
+
+FT4222_STATUS FT4222_SPISlave_GetRxStatus(FT_HANDLE ftHandle, uint16 *pRxSize)
+{
+    SIM_DEV(ftHandle);
+    if (d->mode != MODE_SPI_SLAVE)
+        return FT4222_IS_NOT_SPI_MODE;
+    sim_usb(2);
+    pthread_mutex_lock(&d->lock);
+    *pRxSize = (uint16)stream_available(d);
+    pthread_mutex_unlock(&d->lock);
+    return FT4222_OK;
+}
+
+FT4222_STATUS FT4222_SPISlave_Read(FT_HANDLE ftHandle, uint8 *buffer, uint16 bufferSize,
+    uint16 *sizeOfRead)
+{
+    SIM_DEV(ftHandle);
+    if (d->mode != MODE_SPI_SLAVE)
+        return FT4222_IS_NOT_SPI_MODE;
+    if (buffer == NULL || sizeOfRead == NULL)
+        return FT4222_INVALID_POINTER;
+    pthread_mutex_lock(&d->lock);
+    *sizeOfRead = stream_read(d, buffer, bufferSize);
+    pthread_mutex_unlock(&d->lock);
+    sim_usb(*sizeOfRead);
+    return FT4222_OK;
+}
+
+FT4222_STATUS FT4222_SPISlave_Write(FT_HANDLE ftHandle, uint8 *buffer, uint16 bufferSize,
+    uint16 *sizeTransferred)
+{
+    SIM_DEV(ftHandle);
+    if (d->mode != MODE_SPI_SLAVE)
+        return FT4222_IS_NOT_SPI_MODE;
+    if ((buffer == NULL && bufferSize > 0) || sizeTransferred == NULL)
+        return FT4222_INVALID_POINTER;
+    sim_usb(bufferSize);
+    *sizeTransferred = bufferSize;
+    return FT4222_OK;
+}
+
+FT4222_STATUS FT4222_SPISlave_RxQuickResponse(FT_HANDLE ftHandle, BOOL enable)
+{
+    SIM_DEV(ftHandle);
+    (void)enable;
+    return FT4222_OK;
+}
+
+/* ---------------------------------------------------------------------------
+ * I2C master with EEPROM and register file
+ */
+
+#define I2C_STATUS_IDLE     0x20
+#define I2C_STATUS_ERROR    0x02
+#define I2C_STATUS_ADDR_NACK 0x04
+#define I2C_STATUS_BUS_BUSY 0x40
+
+static int i2c_present(struct sim_dev *d, uint16 addr)
+{
+    if (addr == SIM_EEPROM_ADDR)
+        return now_ns() >= d->eeprom_busy_until;
+    return addr == SIM_REGFILE_ADDR;
+}
+
+static void i2c_write_byte(struct sim_dev *d, uint16 addr, uint32_t n, uint8 b)
+{
+    if (addr == SIM_EEPROM_ADDR) {
+        if (n == 0) {
+            d->eeprom_ptr = (uint16_t)(b << 8);
+        } else if (n == 1) {
+            d->eeprom_ptr = (uint16_t)((d->eeprom_ptr | b) % SIM_EEPROM_SIZE);
+        } else {
+            uint16_t page = d->eeprom_ptr & ~(SIM_EEPROM_PAGE - 1);
+            d->eeprom[d->eeprom_ptr] = b;
+            d->eeprom_ptr = page | ((d->eeprom_ptr + 1) & (SIM_EEPROM_PAGE - 1));
+        }
+    } else {
+        if (n == 0)
+            d->regfile_ptr = b;
+        else
+            d->regfile[d->regfile_ptr++] = b;
+    }
+}
+
+static uint8 i2c_read_byte(struct sim_dev *d, uint16 addr)
+{
+    uint8 b;
+    if (addr == SIM_EEPROM_ADDR) {
+        b = d->eeprom[d->eeprom_ptr];
+        d->eeprom_ptr = (d->eeprom_ptr + 1) % SIM_EEPROM_SIZE;
+        return b;
+    }
+    return d->regfile[d->regfile_ptr++];
+}
+
+static void i2c_stop(struct sim_dev *d)
+{
+    if (d->i2c_wr_active && d->i2c_wr_addr == SIM_EEPROM_ADDR && d->i2c_wr_count > 2)
+        d->eeprom_busy_until = now_ns() + cfg.eeprom_twr_ns;
+    d->i2c_wr_active = 0;
+    d->i2c_held = 0;
+}
+
+static FT4222_STATUS i2c_xfer(struct sim_dev *d, uint16 addr, uint8 flag, uint8 *buffer,
+    uint16 size, uint16 *transferred, int read)
+{
+    uint16 i;
+    int start = (flag & START) || flag == 0;
+
+    if (d->mode != MODE_I2C_MASTER)
+        return FT4222_IS_NOT_I2C_MODE;
+    if (transferred == NULL || (buffer == NULL && size > 0))
+        return FT4222_INVALID_POINTER;
+    if (addr > 0x7F)
+        return FT4222_WRONG_I2C_ADDR;
+    sim_usb(size);
+    pthread_mutex_lock(&d->lock);
+    *transferred = 0;
+    if (start) {
+        if (d->i2c_held && (flag & Repeated_START) != Repeated_START) {
+            /* the bus still belongs to a transaction which was never stopped */
+            d->i2c_status = I2C_STATUS_ERROR | I2C_STATUS_BUS_BUSY;
+            pthread_mutex_unlock(&d->lock);
+            return FT4222_OK;
+        }
+        i2c_stop(d);
+        if (!i2c_present(d, addr)) {
+            d->i2c_status = I2C_STATUS_IDLE | I2C_STATUS_ERROR | I2C_STATUS_ADDR_NACK;
+            /* the master keeps the bus unless it was asked to stop */
+            d->i2c_held = !((flag & STOP) || flag == 0);
+            pthread_mutex_unlock(&d->lock);
+            return FT4222_OK;
+        }
+        d->i2c_held = 1;
+        if (!read) {
+            d->i2c_wr_active = 1;
+            d->i2c_wr_addr = addr;
+            d->i2c_wr_count = 0;
+        }
+    }
+    for (i = 0; i < size; i++) {
+        if (read)
+            buffer[i] = i2c_read_byte(d, addr);
+        else
+            i2c_write_byte(d, addr, d->i2c_wr_count++, buffer[i]);
+    }
+    *transferred = size;
+    d->i2c_status = I2C_STATUS_IDLE;
+    if ((flag & STOP) || flag == 0)
+        i2c_stop(d);
+    pthread_mutex_unlock(&d->lock);
+    return FT4222_OK;
+}
+
+FT4222_STATUS FT4222_I2CMaster_Init(FT_HANDLE ftHandle, uint32 kbps)
+{
+    SIM_DEV(ftHandle);
+    if (kbps < 60 || kbps > 3400)
+        return FT4222_INVALID_PARAMETER;
+    sim_usb(0);
+    d->mode = MODE_I2C_MASTER;
+    d->max_transfer = 512;
+    d->i2c_status = I2C_STATUS_IDLE;
+    d->i2c_held = 0;
+    return FT4222_OK;
+}
+
+FT4222_STATUS FT4222_I2CMaster_Read(FT_HANDLE ftHandle, uint16 deviceAddress, uint8 *buffer,
+    uint16 bufferSize, uint16 *sizeTransferred)
+{
+    SIM_DEV(ftHandle);
+    return i2c_xfer(d, deviceAddress, 0, buffer, bufferSize, sizeTransferred, 1);
+}
+
+FT4222_STATUS FT4222_I2CMaster_Write(FT_HANDLE ftHandle, uint16 deviceAddress, uint8 *buffer,
+    uint16 bufferSize, uint16 *sizeTransferred)
+{
+    SIM_DEV(ftHandle);
+    return i2c_xfer(d, deviceAddress, 0, buffer, bufferSize, sizeTransferred, 0);
+}
+
+FT4222_STATUS FT4222_I2CMaster_ReadEx(FT_HANDLE ftHandle, uint16 deviceAddress, uint8 flag,
+    uint8 *buffer, uint16 bufferSize, uint16 *sizeTransferred)
+{
+    SIM_DEV(ftHandle);
+    return i2c_xfer(d, deviceAddress, flag == NONE ? 0x80 : flag, buffer, bufferSize, sizeTransferred, 1);
+}
+
+FT4222_STATUS FT4222_I2CMaster_WriteEx(FT_HANDLE ftHandle, uint16 deviceAddress, uint8 flag,
+    uint8 *buffer, uint16 bufferSize, uint16 *sizeTransferred)
+{
+    SIM_DEV(ftHandle);
+    return i2c_xfer(d, deviceAddress, flag == NONE ? 0x80 : flag, buffer, bufferSize, sizeTransferred, 0);
+}
+
+FT4222_STATUS FT4222_I2CMaster_Reset(FT_HANDLE ftHandle)
+{
+    SIM_DEV(ftHandle);
+    sim_usb(0);
+    d->i2c_status = I2C_STATUS_IDLE;
+    d->i2c_wr_active = 0;
+    d->i2c_held = 0;
+    return FT4222_OK;
+}
+
+FT4222_STATUS FT4222_I2CMaster_ResetBus(FT_HANDLE ftHandle)
+{
+    return FT4222_I2CMaster_Reset(ftHandle);
+}
+
+FT4222_STATUS FT4222_I2CMaster_GetStatus(FT_HANDLE ftHandle, uint8 *controllerStatus)
+{
+    SIM_DEV(ftHandle);
+    if (d->mode != MODE_I2C_MASTER)
+        return FT4222_IS_NOT_I2C_MODE;
+    sim_usb(1);
+    *controllerStatus = d->i2c_status;
+    return FT4222_OK;
+}
+
+/* ---------------------------------------------------------------------------
+ * I2C slave
+ */
+
+FT4222_STATUS FT4222_I2CSlave_Init(FT_HANDLE ftHandle)
+{
+    SIM_DEV(ftHandle);
+    sim_usb(0);
+    d->mode = MODE_I2C_SLAVE;
+    d->max_transfer = 512;
+    stream_start(d);
+    return FT4222_OK;
+}
+
+FT4222_STATUS FT4222_I2CSlave_Reset(FT_HANDLE ftHandle)
+{
+    SIM_DEV(ftHandle);
+    if (d->mode != MODE_I2C_SLAVE)
+        return FT4222_IS_NOT_I2C_MODE;
+    sim_usb(0);
+    stream_start(d);
+    return FT4222_OK;
+}
+
+FT4222_STATUS FT4222_I2CSlave_GetAddress(FT_HANDLE ftHandle, uint8 *addr)
+{
+    SIM_DEV(ftHandle);
+    if (d->mode != MODE_I2C_SLAVE)
+        return FT4222_IS_NOT_I2C_MODE;
+    sim_usb(1);
+    *addr = d->i2c_slave_addr;
+    return FT4222_OK;
+}
+
+FT4222_STATUS FT4222_I2CSlave_SetAddress(FT_HANDLE ftHandle, uint8 addr)
+{
+    SIM_DEV(ftHandle);
+    if (d->mode != MODE_I2C_SLAVE)
+        return FT4222_IS_NOT_I2C_MODE;
+    if (addr > 0x7F)
+        return FT4222_WRONG_I2C_ADDR;
+    sim_usb(0);
+    d->i2c_slave_addr = addr;
+    return FT4222_OK;
+}
+
+FT4222_STATUS FT4222_I2CSlave_GetRxStatus(FT_HANDLE ftHandle, uint16 *pRxSize)
+{
+    SIM_DEV(ftHandle);
+    if (d->mode != MODE_I2C_SLAVE)
+        return FT4222_IS_NOT_I2C_MODE;
+    sim_usb(2);
+    pthread_mutex_lock(&d->lock);
+    *pRxSize = (uint16)stream_available(d);
+    pthread_mutex_unlock(&d->lock);
+    return FT4222_OK;
+}
+
+FT4222_STATUS FT4222_I2CSlave_Read(FT_HANDLE ftHandle, uint8 *buffer, uint16 bufferSize,
+    uint16 *sizeTransferred)
+{
+    SIM_DEV(ftHandle);
+    if (d->mode != MODE_I2C_SLAVE)
+        return FT4222_IS_NOT_I2C_MODE;
+    if (buffer == NULL || sizeTransferred == NULL)
+        return FT4222_INVALID_POINTER;
+    pthread_mutex_lock(&d->lock);
+    *sizeTransferred = stream_read(d, buffer, bufferSize);
+    pthread_mutex_unlock(&d->lock);
+    sim_usb(*sizeTransferred);
+    return FT4222_OK;
+}
+
+FT4222_STATUS FT4222_I2CSlave_Write(FT_HANDLE ftHandle, uint8 *buffer, uint16 bufferSize,
+    uint16 *sizeTransferred)
+{
+    SIM_DEV(ftHandle);
+    if (d->mode != MODE_I2C_SLAVE)
+        return FT4222_IS_NOT_I2C_MODE;
+    if ((buffer == NULL && bufferSize > 0) || sizeTransferred == NULL)
+        return FT4222_INVALID_POINTER;
+    sim_usb(bufferSize);
+    *sizeTransferred = bufferSize;
+    return FT4222_OK;
+}
+
+FT4222_STATUS FT4222_I2CSlave_SetClockStretch(FT_HANDLE ftHandle, BOOL enable)
+{
+    SIM_DEV(ftHandle);
+    (void)enable;
+    if (d->mode != MODE_I2C_SLAVE)
+        return FT4222_IS_NOT_I2C_MODE;
+    sim_usb(0);
+    return FT4222_OK;
+}
+
+FT4222_STATUS FT4222_I2CSlave_SetRespWord(FT_HANDLE ftHandle, uint8 responseWord)
+{
+    SIM_DEV(ftHandle);
+    (void)responseWord;
+    if (d->mode != MODE_I2C_SLAVE)
+        return FT4222_IS_NOT_I2C_MODE;
+    sim_usb(0);
+    return FT4222_OK;
+}
+
+/* ---------------------------------------------------------------------------
+ * event notification
+ *
+ * A helper thread signals the registered EVENT_HANDLE whenever received data
+ * is pending, the same way libft4222 does from its USB read thread.
+ */
+
+static void *sim_event_main(void *arg)
+{
+    struct sim_dev *d = arg;
+    for (;;) {
+        int pending = 0;
+        pthread_mutex_lock(&d->lock);
+        if (!d->event_thread_running) {
+            pthread_mutex_unlock(&d->lock);
+            break;
+        }
+        if (d->event_mask & FT4222_EVENT_RXCHAR) {
+            if (d->mode == MODE_SPI_SLAVE || d->mode == MODE_I2C_SLAVE)
+                pending = stream_available(d) > 0;
+        }
+        pthread_mutex_unlock(&d->lock);
+        if (pending && d->event) {
+            pthread_mutex_lock(&d->event->eMutex);
+            d->event->iVar = 1;
+            pthread_cond_signal(&d->event->eCondVar);
+            pthread_mutex_unlock(&d->event->eMutex);
+        }
+        sleep_ns(500000);
+    }
+    return NULL;
+}
+
+static void sim_event_stop(struct sim_dev *d)
+{
+    int running;
+    pthread_mutex_lock(&d->lock);
+    running = d->event_thread_running;
+    d->event_thread_running = 0;
+    pthread_mutex_unlock(&d->lock);
+    if (running)
+        pthread_join(d->event_thread, NULL);
+    d->event = NULL;
+    d->event_mask = 0;
+}
+
+FT4222_STATUS FT4222_SetEventNotification(FT_HANDLE ftHandle, DWORD mask, PVOID param)
+{
+    SIM_DEV(ftHandle);
+    if (mask != 0 && param == NULL)
+        return FT4222_INVALID_POINTER;
+    sim_event_stop(d);
+    if (mask == 0)
+        return FT4222_OK;
+    d->event = (EVENT_HANDLE *)param;
+    d->event_mask = mask;
+    d->event_thread_running = 1;
+    if (pthread_create(&d->event_thread, NULL, sim_event_main, d) != 0) {
+        d->event_thread_running = 0;
+        return FT4222_INSUFFICIENT_RESOURCES;
+    }
+    return FT4222_OK;
+}